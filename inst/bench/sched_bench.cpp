@@ -0,0 +1,86 @@
+// Thread scaling of TaskScheduler against the previous tree builder loop:
+// worker threads pulling a shared index under a lock, with the calling thread
+// polling their futures with wait_for(0).
+//
+// 500 tasks of uneven length, like trees of different sizes, are run by each
+// number of threads given on the command line, 1 to 64 by default.  Build it
+// from the root of the package and run it on an otherwise idle host:
+//
+//   g++ -std=c++11 -O2 -pthread -Isrc inst/bench/sched_bench.cpp src/task_scheduler.cpp -o sched_bench
+//   ./sched_bench 1 2 4 8 16 32 64
+//
+// The scheduler column should fall in proportion to the threads up to the
+// number of cores, and the old loop should trail it by the core it polls on.
+#include "task_scheduler.h"
+#include <future>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <atomic>
+
+static volatile double sink;
+
+static void work (int units) {
+    double x = 0;
+    for (int i = 0; i < units * 20000; i++) x += i * 1e-9;
+    sink = x;
+}
+
+static double now () {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+int main (int argc, char** argv) {
+    int ntask = 500;
+    std::vector<int> units(ntask);
+    srand(1);
+    for (int i = 0; i < ntask; i++) units[i] = 1 + rand() % 20;  // Uneven trees.
+
+    std::vector<int> threads;
+    for (int i = 1; i < argc; i++) threads.push_back(atoi(argv[i]));
+    if (threads.empty()) threads = {1, 2, 4, 8, 16, 32, 64};
+
+    printf("threads  scheduler_s  old_loop_s\n");
+    for (int nthreads : threads) {
+        volatile bool interrupt = false;
+
+        double t0 = now();
+        {
+            TaskScheduler scheduler(nthreads, &interrupt);
+            for (int i = 0; i < ntask; i++)
+                scheduler.submit([&units, i] (int) { work(units[i]); });
+            scheduler.wait();
+        }
+        double t1 = now();
+
+        std::mutex mut;
+        int index = 0;
+        std::vector<std::future<void> > results(nthreads);
+        for (int j = 0; j < nthreads; j++)
+            results[j] = std::async(std::launch::async, [&] {
+                while (true) {
+                    int i;
+                    {
+                        std::lock_guard<std::mutex> lk(mut);
+                        i = index++;
+                    }
+                    if (i >= ntask) return;
+                    work(units[i]);
+                }
+            });
+        int done = 0;
+        std::vector<bool> got(nthreads, false);
+        do {
+            for (int j = 0; j < nthreads; j++)
+                if (!got[j] && results[j].wait_for(std::chrono::seconds {0}) == std::future_status::ready) {
+                    results[j].get();
+                    got[j] = true;
+                    done++;
+                }
+        } while (done < nthreads);
+        double t2 = now();
+
+        printf("%7d  %11.3f  %10.3f\n", nthreads, t1 - t0, t2 - t1);
+    }
+    return 0;
+}
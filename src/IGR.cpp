@@ -1,11 +1,10 @@
 #include "IGR.h"
 
-IGR::IGR(const vector<double>& gain_ratio, int nvars, unsigned seed, volatile bool* pInterrupt, bool isParallel)
+IGR::IGR(const vector<double>& gain_ratio, int nvars, unsigned seed, volatile bool* pInterrupt, bool isParallel, Workspace* workspace)
     : gain_ratio_vec_(gain_ratio) {
 
-    weights_ = vector<double>(gain_ratio.size()+1);
-    wst_     = vector<int>(gain_ratio.size()+1);
-    seed_    = seed;
+    workspace_ = workspace;
+    seed_      = seed;
 
     pInterrupt_ = pInterrupt;
     isParallel_ = isParallel;
@@ -14,14 +13,24 @@ IGR::IGR(const vector<double>& gain_ratio, int nvars, unsigned seed, volatile bo
     nvars_ = nvars >= n ? n : nvars;
 }
 
+const vector<int>& IGR::getSampledIdxs()
+/*
+ * randomly pick < this->m_ > variables from all variables according to their weights
+ */
+{
+    Sampling rs (seed_, pInterrupt_, isParallel_);
+    vector<int>& wrs_vec = workspace_->sample_vec_;
+    rs.nonReplaceWeightedSample(gain_ratio_vec_, nvars_, wrs_vec, workspace_->weights_, workspace_->wst_);
+    return wrs_vec;
+}
+
 int IGR::getSelectedIdx()
 /*
  * select the most weighted variable from < this->m_ > variables that
  * are randomly picked from all variables according to their weights
  */
 {
-    Sampling rs (seed_, pInterrupt_, isParallel_);
-    const vector<int>& wrs_vec = rs.nonReplaceWeightedSample(gain_ratio_vec_, nvars_);
+    const vector<int>& wrs_vec = getSampledIdxs();
     int max = -1;
     bool is_max_set = false;
     for (int rand_num : wrs_vec) {
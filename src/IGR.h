@@ -3,6 +3,7 @@
 
 #include "utility.h"
 #include "sampling.h"
+#include "workspace.h"
 
 using namespace std;
 
@@ -11,8 +12,7 @@ private:
     int nvars_;  //subspace size
     unsigned seed_;
 
-    vector<double> weights_;
-    vector<int>    wst_;
+    Workspace* workspace_;  // Scratch memory for weighted sampling.
 
     volatile bool* pInterrupt_;
     bool isParallel_;
@@ -20,8 +20,9 @@ private:
     const vector<double>& gain_ratio_vec_;
 
 public:
-    IGR(const vector<double>& gain_ratio, int nvars, unsigned seed, volatile bool* pInterrupt, bool isParallel);
+    IGR(const vector<double>& gain_ratio, int nvars, unsigned seed, volatile bool* pInterrupt, bool isParallel, Workspace* workspace);
 
+    const vector<int>& getSampledIdxs();
     int  getSelectedIdx();
 };
 
@@ -5,34 +5,64 @@ C4p5Selector::C4p5Selector (
         TargetData* targdata,
         MetaData* meta_data,
         int min_node_size,
-        const vector<int>& obs_vec,
+        int nrand_splits,
+        int igr_sampsize,
+        const ObsRange& obs_vec,
         const vector<int>& var_vec,
         int mtry,
         unsigned seed,
         volatile bool* pInterrupt,
-        bool isParallel)
+        bool isParallel,
+        Workspace* workspace,
+        TaskScheduler* scheduler,
+        vector<Workspace>* thread_workspaces,
+        const vector<vector<int> >* psorted_obs_vecs,
+        map<int, vector<int> >* phist_map)
     : VarSelector(train_set, targdata, meta_data, obs_vec, var_vec) {
     seed_ = seed;
+    workspace_ = workspace;
+    workspace_->cand_var_vec_.clear();
     info_ = calcEntropy(obs_vec);
     mtry_ = mtry;
     min_node_size_ = min_node_size;
+    nrand_splits_ = nrand_splits;
+    igr_sampsize_ = igr_sampsize;
     pInterrupt_ = pInterrupt;
     isParallel_ = isParallel;
-
+    psorted_obs_vecs_ = psorted_obs_vecs;
+    phist_map_ = phist_map;
+    scheduler_ = scheduler;
+    thread_workspaces_ = thread_workspaces;
 }
 
-void C4p5Selector::handleDiscVar (int var_idx)
+void C4p5Selector::handleDiscVar (int var_idx, Workspace* ws)
 /*
- * Calculate corresponding information if split by discrete variable <var_idx>.
+ * Calculate corresponding information if split by discrete variable <var_idx>,
+ * from the table of label frequency counts for its levels, counted in one pass over the node.
  *
  * If no more than 2 child nodes contain at least <MIN_NODE_SIZE_>
  * instances, don't split training set by this attribute
  */
 {
-    map<int, vector<int> > mapper = train_set_->splitDiscVar(obs_vec_, var_idx);
+    int nlabels = meta_data_->nlabels();
+    int nlevels = meta_data_->getNumValues(var_idx);
+    vector<int>& table        = ws->level_label_vec_;
+    vector<int>& level_counts = ws->level_count_vec_;
+    switch (train_set_->getLevelWidth(var_idx)) {
+    case sizeof(unsigned char):
+        targ_data_->getLevelLabelFreqCount(obs_vec_, train_set_->getLevels<unsigned char>(var_idx), nlevels, table, level_counts);
+        break;
+    case sizeof(unsigned short):
+        targ_data_->getLevelLabelFreqCount(obs_vec_, train_set_->getLevels<unsigned short>(var_idx), nlevels, table, level_counts);
+        break;
+    default:
+        targ_data_->getLevelLabelFreqCount(obs_vec_, train_set_->getLevels<int>(var_idx), nlevels, table, level_counts);
+        break;
+    }
+
     int count = 0;
-    for (map<int, vector<int> >::iterator iter = mapper.begin(); iter != mapper.end(); ++iter)
-        if (int(iter->second.size()) >= min_node_size_) count++;
+    for (int level = 0; level < nlevels; level++)
+        if (level_counts[level] >= min_node_size_) count++;
 
     if (count < 2) return;
 
@@ -42,11 +72,11 @@ void C4p5Selector::handleDiscVar (int var_idx)
      */
     double subinfo = 0;
     double split_info = 0;
-    for (map<int, vector<int> >::iterator iter = mapper.begin(); iter != mapper.end(); ++iter) {
-        int nobs_sub = iter->second.size();
+    for (int level = 0; level < nlevels; level++) {
+        int nobs_sub = level_counts[level];
         if (nobs_sub != 0) {
             split_info += train_set_->nlogn(nobs_sub);
-            subinfo += sumNlogn(targ_data_->getLabelFreqCount(iter->second), nobs_sub);
+            subinfo += sumNlogn(&table[level * nlabels], nlabels, nobs_sub);
         }
     }
 
@@ -55,90 +85,375 @@ void C4p5Selector::handleDiscVar (int var_idx)
 
     split_info = (train_set_->nlogn(nobs_) -  split_info) / nobs_;
 
-    cand_splits_map_[var_idx].swap(mapper);
-    info_gain_map_[var_idx] = info_gain;
-    split_info_map_[var_idx] = split_info;
+    setCandidate(var_idx, info_gain, split_info);
 }
 
 template<class T>
-void C4p5Selector::handleContVar (int var_idx) {
-    //TODO: Need better way to deal with different type of variable, that is DISCRETE, INTSXP, REALSXP.
+void C4p5Selector::handleContVar (int var_idx, Workspace* ws, const T* var_array)
+/*
+ * Calculate corresponding information if split by numerical variable <var_idx>, whose values, or their ranks,
+ * are in <var_array>.  The split value is read from the observation on the left of the split point.
+ */
+{
     if (nobs_ < 2 * min_node_size_) return;
 
-    vector<int> sorted_obs_vec = obs_vec_;
-    sort(sorted_obs_vec.begin(), sorted_obs_vec.end(), VarValueComparor<T>(train_set_, var_idx));
+    // Use the presorted order if available, otherwise sort the observations of this node.
+    vector<int>& node_sorted_vec = ws->sorted_obs_vec_;
+    if (psorted_obs_vecs_ == NULL) {
+        node_sorted_vec.assign(obs_vec_.begin(), obs_vec_.end());
+        sort(node_sorted_vec.begin(), node_sorted_vec.end(), VarValueComparor<T>(var_array));
+    }
+    const vector<int>& sorted_obs_vec = psorted_obs_vecs_ == NULL ? node_sorted_vec : (*psorted_obs_vecs_)[var_idx];
 
-    vector<int> left_dstr(meta_data_->nlabels(), 0);
-    vector<int> right_dstr = targ_data_->getLabelFreqCount(sorted_obs_vec);
+    int nlabels = meta_data_->nlabels();
+    vector<int>& left_dstr  = ws->left_dstr_;
+    vector<int>& right_dstr = ws->right_dstr_;
+    left_dstr.assign(nlabels, 0);
+    targ_data_->getLabelFreqCount(ObsRange(sorted_obs_vec, obs_vec_.counts()), right_dstr);
 
+    /*
+     * Running sums of N*log(N) over the labels on each side, updated for the one label that moves at each step,
+     * estimate the entropy at a split point in O(1).  The estimate only rules out split points that cannot beat
+     * the best so far, taking <margin> for rounding errors; the others are evaluated by calcBisectSubinfo() as before,
+     * so the split found is the same, bit for bit, as evaluating every split point.
+     */
+    double left_sum  = 0;
+    double right_sum = 0;
+    for (int label = 0; label < nlabels; label++)
+        right_sum += train_set_->nlogn(right_dstr[label]);
 
-    int current_label = -1;
-    for (int i = 0; i < min_node_size_; ++i) {
-        current_label = targ_data_->getLabel(sorted_obs_vec[i]) - 1;
-        left_dstr[current_label]++;
-        right_dstr[current_label]--;
-    }
+    double margin_step = 4 * numeric_limits<double>::epsilon() * train_set_->nlogn(nobs_) / nobs_;  // Bound of rounding errors of one step.
+    double margin      = (nlabels + 4) * margin_step;
 
-    T* var_array = train_set_->getVar<T>(var_idx);
-    double current_value = var_array[sorted_obs_vec[min_node_size_-1]];
+    /*
+     * Copies of an observation are adjacent in the sorted order, with the same value and label,
+     * so the split points are between distinct observations, where the left side has <nleft> copies,
+     * with at least <min_node_size_> copies on the left and more than that on the right.
+     */
+    int    n = sorted_obs_vec.size();
+    int    nleft = 0;
+    int    current_label = -1;
+    T      current_value = 0;
+    int    current_obs = -1;
     double subinfo;
-    double split_value = -1;
-    bool subinfo_is_set = false;
-    int pos = min_node_size_ - 1;
-    for (int i = min_node_size_; i < nobs_ - min_node_size_; ++i) {
-        int next_label = targ_data_->getLabel(sorted_obs_vec[i]) - 1;
-        double next_value = var_array[sorted_obs_vec[i]];
-        if (current_label != next_label && current_value != next_value) {
-            double new_subinfo = calcBisectSubinfo(left_dstr, i, right_dstr, nobs_ - i);
-            if (subinfo_is_set) {
-                if (new_subinfo < subinfo) {
+    int    split_obs = -1;
+    bool   subinfo_is_set = false;
+    int    split_nleft = min_node_size_;
+    for (int i = 0; i < n && nleft < nobs_ - min_node_size_; ++i) {
+        int obs = sorted_obs_vec[i];
+        int next_label = targ_data_->getLabel(obs) - 1;
+        T   next_value = var_array[obs];
+        if (nleft >= min_node_size_ && current_label != next_label && current_value != next_value) {
+            double est_subinfo = (train_set_->nlogn(nleft) - left_sum + train_set_->nlogn(nobs_ - nleft) - right_sum) / nobs_;
+            if (!subinfo_is_set || est_subinfo < subinfo + margin) {
+                double new_subinfo = calcBisectSubinfo(left_dstr, nleft, right_dstr, nobs_ - nleft);
+                if (!subinfo_is_set || new_subinfo < subinfo) {
                     subinfo = new_subinfo;
-                    split_value = current_value;
-                    pos = i - 1;
+                    split_obs = current_obs;
+                    split_nleft = nleft;
+                    subinfo_is_set = true;
                 }
-            } else {
-                subinfo = new_subinfo;
-                split_value = current_value;
-                subinfo_is_set = true;
-                pos = i - 1;
             }
-
         }
-        left_dstr[next_label]++;
-        right_dstr[next_label]--;
+
+        int count = obs_vec_.count(obs);
+        left_sum  += train_set_->nlogn(left_dstr[next_label] + count) - train_set_->nlogn(left_dstr[next_label]);
+        right_sum += train_set_->nlogn(right_dstr[next_label] - count) - train_set_->nlogn(right_dstr[next_label]);
+        margin    += margin_step;
+        left_dstr[next_label]  += count;
+        right_dstr[next_label] -= count;
+        nleft += count;
         current_label = next_label;
         current_value = next_value;
+        current_obs   = obs;
+    }
+
+    if (subinfo_is_set) {
+        double info_gain = info_ - subinfo;
+        if (info_gain <= 0) return;
+
+        double split_info = (train_set_->nlogn(nobs_) - train_set_->nlogn(split_nleft) - train_set_->nlogn(nobs_ - split_nleft)) / nobs_;
+        setCandidate(var_idx, info_gain, split_info, train_set_->getNumValue(var_idx, split_obs));
+    }
+}
+
+template<class T>
+void C4p5Selector::handleCountedVar (int var_idx, Workspace* ws, const T* rank_array)
+/*
+ * The same as handleContVar(), but for a variable of few distinct values, whose ranks are in <rank_array>:
+ * the label frequency counts of each rank are counted in one pass over the node instead of sorting it,
+ * and the ranks are scanned in ascending order, which is the sorted order, run by run.
+ *
+ * As in the sorted order ties are broken by observation index, the first and the last observation of a run
+ * are those of the smallest and the largest index, so the split points tried and the split found are the same.
+ */
+{
+    if (nobs_ < 2 * min_node_size_) return;
+
+    int nlabels = meta_data_->nlabels();
+    int nranks  = train_set_->getNumRanks(var_idx);
+    vector<int>& table      = ws->rank_label_vec_;
+    vector<int>& first_obs  = ws->rank_first_vec_;
+    vector<int>& last_obs   = ws->rank_last_vec_;
+    table.assign(nranks * nlabels, 0);
+    first_obs.assign(nranks, -1);
+    last_obs.assign(nranks, -1);
+    for (int obs : obs_vec_) {
+        int rank = rank_array[obs];
+        table[rank * nlabels + targ_data_->getLabel(obs) - 1] += obs_vec_.count(obs);
+        if (first_obs[rank] == -1 || obs < first_obs[rank]) first_obs[rank] = obs;
+        if (obs > last_obs[rank]) last_obs[rank] = obs;
+    }
+
+    vector<int>& left_dstr  = ws->left_dstr_;
+    vector<int>& right_dstr = ws->right_dstr_;
+    left_dstr.assign(nlabels, 0);
+    targ_data_->getLabelFreqCount(obs_vec_, right_dstr);
+
+    // Running sums of N*log(N) to screen split points, as in handleContVar(), with the margin grown per update.
+    double left_sum  = 0;
+    double right_sum = 0;
+    for (int label = 0; label < nlabels; label++)
+        right_sum += train_set_->nlogn(right_dstr[label]);
+
+    double margin_step = 4 * numeric_limits<double>::epsilon() * train_set_->nlogn(nobs_) / nobs_;
+    double margin      = (nlabels + 4) * margin_step;
+
+    int    nleft = 0;
+    int    current_label = -1;
+    int    current_obs = -1;
+    double subinfo;
+    int    split_obs = -1;
+    bool   subinfo_is_set = false;
+    int    split_nleft = min_node_size_;
+    for (int rank = 0; rank < nranks && nleft < nobs_ - min_node_size_; rank++) {
+        if (first_obs[rank] == -1) continue;
+
+        int next_label = targ_data_->getLabel(first_obs[rank]) - 1;
+        if (nleft >= min_node_size_ && current_label != next_label) {
+            double est_subinfo = (train_set_->nlogn(nleft) - left_sum + train_set_->nlogn(nobs_ - nleft) - right_sum) / nobs_;
+            if (!subinfo_is_set || est_subinfo < subinfo + margin) {
+                double new_subinfo = calcBisectSubinfo(left_dstr, nleft, right_dstr, nobs_ - nleft);
+                if (!subinfo_is_set || new_subinfo < subinfo) {
+                    subinfo = new_subinfo;
+                    split_obs = current_obs;
+                    split_nleft = nleft;
+                    subinfo_is_set = true;
+                }
+            }
+        }
+
+        const int* counts = &table[rank * nlabels];
+        for (int label = 0; label < nlabels; label++) {
+            int count = counts[label];
+            if (count == 0) continue;
+
+            left_sum  += train_set_->nlogn(left_dstr[label] + count) - train_set_->nlogn(left_dstr[label]);
+            right_sum += train_set_->nlogn(right_dstr[label] - count) - train_set_->nlogn(right_dstr[label]);
+            margin    += margin_step;
+            left_dstr[label]  += count;
+            right_dstr[label] -= count;
+            nleft += count;
+        }
+        current_label = targ_data_->getLabel(last_obs[rank]) - 1;
+        current_obs   = last_obs[rank];
     }
 
     if (subinfo_is_set) {
         double info_gain = info_ - subinfo;
         if (info_gain <= 0) return;
 
-        info_gain_map_[var_idx] = info_gain;
+        double split_info = (train_set_->nlogn(nobs_) - train_set_->nlogn(split_nleft) - train_set_->nlogn(nobs_ - split_nleft)) / nobs_;
+        setCandidate(var_idx, info_gain, split_info, train_set_->getNumValue(var_idx, split_obs));
+    }
+}
+
+template<class T>
+void C4p5Selector::handleRandomSplit (int var_idx, Workspace* ws, const T* var_array)
+/*
+ * Calculate corresponding information if split by numerical variable <var_idx> at the best of
+ * <nrand_splits_> split values drawn uniformly between its minimum and maximum in this node,
+ * each tried in one pass over the observations, without sorting.
+ */
+{
+    if (nobs_ < 2 * min_node_size_) return;
 
-//        T* vararray = (T *) ((*train_set_)[var_idx]);
-//        double split_value = (vararray[sorted_obs_vec[pos]] + vararray[sorted_obs_vec[pos + 1]]) / 2;
-        double split_info = (train_set_->nlogn(nobs_) - train_set_->nlogn(pos + 1) - train_set_->nlogn(nobs_ - pos - 1)) / nobs_;
-        split_info_map_[var_idx] = split_info;
+    T  min_value = var_array[*obs_vec_.begin()];
+    T  max_value = min_value;
+    for (int obs : obs_vec_) {
+        if (var_array[obs] < min_value) min_value = var_array[obs];
+        if (var_array[obs] > max_value) max_value = var_array[obs];
+    }
+    if (min_value == max_value) return;
 
-        map<int, vector<int> > mapper = train_set_->splitPosition(sorted_obs_vec, pos);
-        cand_splits_map_[var_idx].swap(mapper);
+    // The split values depend on the node and the variable, not on which thread evaluates it.
+    seed_seq seq {seed_, (unsigned) var_idx};
+    default_random_engine re(seq);
+    uniform_real_distribution<double> urd {(double) min_value, (double) max_value};
+
+    int nlabels = meta_data_->nlabels();
+    vector<int>& node_dstr  = ws->label_count_vec_;
+    vector<int>& left_dstr  = ws->left_dstr_;
+    vector<int>& right_dstr = ws->right_dstr_;
+    targ_data_->getLabelFreqCount(obs_vec_, node_dstr);
+    right_dstr.resize(nlabels);
+
+    double subinfo;
+    double split_value = -1;
+    int    split_nleft = 0;
+    bool   subinfo_is_set = false;
+    for (int k = 0; k < nrand_splits_; k++) {
+        double value = urd(re);
+
+        left_dstr.assign(nlabels, 0);
+        int nleft = 0;
+        for (int obs : obs_vec_) {
+            if (var_array[obs] <= value) {
+                int count = obs_vec_.count(obs);
+                left_dstr[targ_data_->getLabel(obs) - 1] += count;
+                nleft += count;
+            }
+        }
+        if (nleft < min_node_size_ || nleft >= nobs_ - min_node_size_) continue;
 
-        split_value_map_[var_idx] = split_value;
+        for (int label = 0; label < nlabels; label++)
+            right_dstr[label] = node_dstr[label] - left_dstr[label];
+
+        double new_subinfo = calcBisectSubinfo(left_dstr, nleft, right_dstr, nobs_ - nleft);
+        if (!subinfo_is_set || new_subinfo < subinfo) {
+            subinfo = new_subinfo;
+            split_value = value;
+            split_nleft = nleft;
+            subinfo_is_set = true;
+        }
+    }
+
+    if (subinfo_is_set) {
+        double info_gain = info_ - subinfo;
+        if (info_gain <= 0) return;
+
+        double split_info = (train_set_->nlogn(nobs_) - train_set_->nlogn(split_nleft) - train_set_->nlogn(nobs_ - split_nleft)) / nobs_;
+        setCandidate(var_idx, info_gain, split_info, split_value);
     }
 }
 
-void C4p5Selector::handleContVar (int var_idx)
+const vector<int>& C4p5Selector::getHistogram (int var_idx)
+/*
+ * Label frequency count in each bin of variable <var_idx> for this node.
+ *
+ * Reuse the histogram in <phist_map_> if it has been derived from the parent and siblings,
+ * otherwise count it in one pass and keep it for the siblings.
+ */
+{
+    // Nodes of the map stay where they are when others are inserted, so only lookup and insertion are guarded.
+    unique_lock<mutex> lk(mut_);
+    map<int, vector<int> >::iterator iter = phist_map_->find(var_idx);
+    if (iter != phist_map_->end()) return iter->second;
+
+    vector<int>& hist = (*phist_map_)[var_idx];
+    lk.unlock();
+
+    int nlabels = meta_data_->nlabels();
+    const unsigned char* bins = train_set_->getBins(var_idx);
+
+    hist.assign(train_set_->getNumBins(var_idx) * nlabels, 0);
+    for (int obs : obs_vec_)
+        hist[bins[obs] * nlabels + targ_data_->getLabel(obs) - 1] += obs_vec_.count(obs);
+
+    return hist;
+}
+
+void C4p5Selector::handleBinnedVar (int var_idx, Workspace* ws)
+/*
+ * Calculate corresponding information if split by numerical variable <var_idx>,
+ * by scanning the label histogram of its bins instead of the sorted observations.
+ */
+{
+    if (nobs_ < 2 * min_node_size_) return;
+
+    int nlabels = meta_data_->nlabels();
+    int nbins   = train_set_->getNumBins(var_idx);
+    const vector<int>& hist = getHistogram(var_idx);
+
+    vector<int>& left_dstr  = ws->left_dstr_;
+    vector<int>& right_dstr = ws->right_dstr_;
+    left_dstr.assign(nlabels, 0);
+    right_dstr.assign(nlabels, 0);
+    for (int bin = 0; bin < nbins; bin++)
+        for (int label = 0; label < nlabels; label++)
+            right_dstr[label] += hist[bin * nlabels + label];
+
+    double subinfo;
+    int  split_bin = -1;
+    int  split_nleft = 0;
+    int  nleft = 0;
+    bool subinfo_is_set = false;
+    for (int bin = 0; bin < nbins - 1; bin++) {
+        int nbin = 0;
+        for (int label = 0; label < nlabels; label++) {
+            int count = hist[bin * nlabels + label];
+            left_dstr[label]  += count;
+            right_dstr[label] -= count;
+            nbin += count;
+        }
+
+        if (nbin == 0) continue;  // The same split as the previous non-empty bin.
+
+        nleft += nbin;
+        if (nleft < min_node_size_) continue;
+        if (nobs_ - nleft <= min_node_size_) break;
+
+        double new_subinfo = calcBisectSubinfo(left_dstr, nleft, right_dstr, nobs_ - nleft);
+        if (!subinfo_is_set || new_subinfo < subinfo) {
+            subinfo = new_subinfo;
+            split_bin = bin;
+            split_nleft = nleft;
+            subinfo_is_set = true;
+        }
+    }
+
+    if (subinfo_is_set) {
+        double info_gain = info_ - subinfo;
+        if (info_gain <= 0) return;
+
+        double split_info = (train_set_->nlogn(nobs_) - train_set_->nlogn(split_nleft) - train_set_->nlogn(nobs_ - split_nleft)) / nobs_;
+        setCandidate(var_idx, info_gain, split_info, train_set_->getBinEdge(var_idx, split_bin));
+    }
+}
+
+void C4p5Selector::handleContVar (int var_idx, Workspace* ws)
 /*
  * Calculate corresponding information if split by numerical variable <var_idx>.
  */
 {
+    if (phist_map_ != NULL) {
+        handleBinnedVar(var_idx, ws);
+        return;
+    }
+
+    /*
+     * Random splits are tried in a pass over the values, while the best split is searched in the ranks if encoded,
+     * by counting instead of sorting if the table of label counts for the ranks is no larger than the node.
+     */
+    if (nrand_splits_ == 0) {
+        switch (train_set_->getRankWidth(var_idx)) {
+        case sizeof(unsigned short):
+            if (psorted_obs_vecs_ == NULL && train_set_->getNumRanks(var_idx) * meta_data_->nlabels() <= (int) obs_vec_.size())
+                handleCountedVar(var_idx, ws, train_set_->getRanks<unsigned short>(var_idx));
+            else
+                handleContVar(var_idx, ws, train_set_->getRanks<unsigned short>(var_idx));
+            return;
+        }
+    }
+
     switch (meta_data_->getVarType(var_idx)) {
     case INTSXP:
-        handleContVar<int>(var_idx);
+        if (nrand_splits_ > 0) handleRandomSplit(var_idx, ws, train_set_->getVar<int>(var_idx));
+        else handleContVar(var_idx, ws, train_set_->getVar<int>(var_idx));
         break;
     case REALSXP:
-        handleContVar<double>(var_idx);
+        if (nrand_splits_ > 0) handleRandomSplit(var_idx, ws, train_set_->getVar<double>(var_idx));
+        else handleContVar(var_idx, ws, train_set_->getVar<double>(var_idx));
         break;
     default:
         throw std::range_error(meta_data_->getVarName(var_idx) + UNEXPECTED_VAR_TYPE_MSG);
@@ -148,72 +463,215 @@ void C4p5Selector::handleContVar (int var_idx)
 void C4p5Selector::calcInfos (const vector<int>& var_vec)
 /*
  * Calculate the impurity difference when using each variable for node splitting.
+ *
+ * Variables of a large node are shared with idle threads of <scheduler_>, each using the scratch memory
+ * it keeps in <thread_workspaces_> across nodes.
  */
 {
     int n = var_vec.size();
-    for (int i = 0; i < n; i++) {
+    if (scheduler_ != NULL && nobs_ >= PAR_NODE_MIN_OBS && n > 1) {
 
+        atomic<int> next_var(0);
+        scheduler_->runParallel(min(n, scheduler_->nthreads()), [this, &var_vec, &next_var, n] (int copy, int index) {
+            Workspace* ws = copy == 0 ? workspace_ : &(*thread_workspaces_)[index];
 
-        if (!isParallel_ && check_interrupt()) {
-            // If run sequentially, check user interruption directly.
-            throw interrupt_exception(MODEL_INTERRUPT_MSG);
-        } else if (*pInterrupt_) {
-            // Otherwise, return immediately if run in parallel.
-            return;
-        }
+            for (int i = next_var++; i < n && !*pInterrupt_; i = next_var++)
+                calcInfo(var_vec[i], ws);
+        });
+
+    } else {
+
+        for (int i = 0; i < n; i++) {
+
+
+            if (!isParallel_ && check_interrupt()) {
+                // If run sequentially, check user interruption directly.
+                throw interrupt_exception(MODEL_INTERRUPT_MSG);
+            } else if (*pInterrupt_) {
+                // Otherwise, return immediately if run in parallel.
+                return;
+            }
 
-        if (meta_data_->getVarType(var_vec[i]) == DISCRETE) {
-            handleDiscVar(var_vec[i]);
-        } else {
-            handleContVar(var_vec[i]);
+            calcInfo(var_vec[i], workspace_);
         }
+
+    }
+
+    // Candidates are visited in ascending order of variables, whatever the order they were sampled or evaluated.
+    sort(workspace_->cand_var_vec_.begin(), workspace_->cand_var_vec_.end());
+}
+
+void C4p5Selector::calcInfo (int var_idx, Workspace* ws) {
+    if (meta_data_->getVarType(var_idx) == DISCRETE) {
+        handleDiscVar(var_idx, ws);
+    } else {
+        handleContVar(var_idx, ws);
     }
 }
 
+void C4p5Selector::setCandidate (int vindex, double info_gain, double split_info, double split_value)
+/*
+ * Record variable <vindex> as a candidate for splitting, with its impurity measures.
+ */
+{
+    workspace_->info_gain_vec_[vindex]   = info_gain;
+    workspace_->split_info_vec_[vindex]  = split_info;
+    workspace_->split_value_vec_[vindex] = split_value;
+
+    lock_guard<mutex> lk(mut_);
+    workspace_->cand_var_vec_.push_back(vindex);
+}
+
 double C4p5Selector::averageInfoGain () {
+    const vector<int>& cand_var_vec = workspace_->cand_var_vec_;
     double total_info_gain = 0;
-    for (map<int, double>::iterator iter = info_gain_map_.begin(); iter != info_gain_map_.end(); ++iter)
-        total_info_gain += iter->second;
+    for (vector<int>::const_iterator iter = cand_var_vec.begin(); iter != cand_var_vec.end(); ++iter)
+        total_info_gain += workspace_->info_gain_vec_[*iter];
 
     // the average_info_gain minus 0.001 to avoid the situation where all the info gain is the same
-    double average_info_gain = total_info_gain / (double) ((info_gain_map_.size())) - 0.000001;
+    double average_info_gain = total_info_gain / (double) ((cand_var_vec.size())) - 0.000001;
     return average_info_gain;
 }
 
+void C4p5Selector::weightCandidates ()
+/*
+ * Collect the candidate variables with no less than the average information gain and positive split info
+ * into <pool_vec_>, with their information gain ratios as weights in <cand_gain_ratio_vec_>.
+ */
+{
+    double average_info_gain = averageInfoGain();
+
+    const vector<double>& info_gain_vec  = workspace_->info_gain_vec_;
+    const vector<double>& split_info_vec = workspace_->split_info_vec_;
+    const vector<int>&    all_cand_vec   = workspace_->cand_var_vec_;
+
+    vector<int>&    cand_var_vec        = workspace_->pool_vec_;
+    vector<double>& cand_gain_ratio_vec = workspace_->cand_gain_ratio_vec_;
+    cand_var_vec.clear();
+    cand_gain_ratio_vec.clear();
+    for (vector<int>::const_iterator iter = all_cand_vec.begin(); iter != all_cand_vec.end(); ++iter) {
+        if (info_gain_vec[*iter] >= average_info_gain) {
+            double split_info = split_info_vec[*iter];
+            if (split_info > 0) {
+                cand_var_vec.push_back(*iter);
+                cand_gain_ratio_vec.push_back(info_gain_vec[*iter] / split_info);
+            }
+        }
+    }
+}
+
+bool C4p5Selector::doApproxIGRSelection (VarSelectRes& res)
+/*
+ * IGR weighting by gain ratios estimated on a random subsample of <igr_sampsize_> observations of the node:
+ * All the variables are evaluated on the subsample, and only the <mtry_> variables sampled by the estimates
+ * are evaluated on the whole node, to choose the one of the highest gain ratio.
+ *
+ * Return false, leaving the choice to the exact method, if no variable is worth splitting by the estimates,
+ * or none of the sampled variables is on the whole node.
+ */
+{
+    // Draw the subsample from a random stream apart from those sampling variables and split values.
+    vector<int>& sub_obs_vec = workspace_->sub_obs_vec_;
+    sub_obs_vec.assign(obs_vec_.begin(), obs_vec_.end());
+    seed_seq seq {seed_, 0u, 0u};
+    default_random_engine re(seq);
+    int n = sub_obs_vec.size();
+    for (int i = 0; i < igr_sampsize_; i++) {
+        uniform_int_distribution<int> uid {i, n - 1};
+        swap(sub_obs_vec[i], sub_obs_vec[uid(re)]);
+    }
+    ObsRange sub_obs_range(sub_obs_vec.data(), sub_obs_vec.data() + igr_sampsize_, obs_vec_.counts());
+
+    // The estimates are recorded into the workspace as candidates, to be overwritten by the exact ones.
+    map<int, vector<int> > sub_hist_map;
+    C4p5Selector estimator(train_set_, targ_data_, meta_data_, min_node_size_, nrand_splits_, 0, sub_obs_range, var_vec_, mtry_, seed_,
+            pInterrupt_, isParallel_, workspace_, scheduler_, thread_workspaces_, NULL, phist_map_ != NULL ? &sub_hist_map : NULL);
+    estimator.calcInfos(var_vec_);
+
+    if (!isParallel_ && check_interrupt()) {
+        // If run sequentially, check user interruption directly.
+        throw interrupt_exception(MODEL_INTERRUPT_MSG);
+    } else if (workspace_->cand_var_vec_.empty() || *pInterrupt_) {
+        return false;
+    }
+
+    weightCandidates();
+    if (workspace_->pool_vec_.empty()) return false;
+
+    IGR igr(workspace_->cand_gain_ratio_vec_, mtry_, seed_, pInterrupt_, isParallel_, workspace_);
+    vector<int>& sampled_var_vec = workspace_->igr_var_vec_;
+    sampled_var_vec.clear();
+    for (int index : igr.getSampledIdxs())
+        sampled_var_vec.push_back(workspace_->pool_vec_[index]);
+
+    workspace_->cand_var_vec_.clear();
+    calcInfos(sampled_var_vec);
+
+    if (!isParallel_ && check_interrupt()) {
+        // If run sequentially, check user interruption directly.
+        throw interrupt_exception(MODEL_INTERRUPT_MSG);
+    } else if (*pInterrupt_) {
+        setResult(-1, res);
+        return true;
+    }
+
+    // As IGR::getSelectedIdx(), the highest gain ratio wins, the later sampled on ties.
+    const vector<int>& cand_var_vec = workspace_->cand_var_vec_;
+    int    vindex     = -1;
+    double gain_ratio = 0;
+    for (int var : sampled_var_vec) {
+        if (!binary_search(cand_var_vec.begin(), cand_var_vec.end(), var)) continue;
+
+        double split_info = workspace_->split_info_vec_[var];
+        if (split_info <= 0) continue;
+
+        double new_gain_ratio = workspace_->info_gain_vec_[var] / split_info;
+        if (vindex == -1 || new_gain_ratio >= gain_ratio) {
+            vindex     = var;
+            gain_ratio = new_gain_ratio;
+        }
+    }
+    if (vindex == -1) return false;
+
+    setResult(vindex, res, gain_ratio);
+    return true;
+}
+
 void C4p5Selector::doIGRSelection (VarSelectRes& res)
 /*
  * calculate all information gain when split by any one of the variables
  * from the weighted randomly selected subspace of size <mtry_>
+ *
+ * If <igr_sampsize_> is set and less than the number of observations of the node, try estimating the weights first.
  */
 {
+    if (igr_sampsize_ > 0 && (int) obs_vec_.size() > igr_sampsize_ && (int) var_vec_.size() > mtry_) {
+        if (doApproxIGRSelection(res)) return;
+        workspace_->cand_var_vec_.clear();
+    }
+
     calcInfos(var_vec_);
 
     if (!isParallel_ && check_interrupt()) {
         // If run sequentially, check user interruption directly.
         throw interrupt_exception(MODEL_INTERRUPT_MSG);
-    } else if (info_gain_map_.empty() || *pInterrupt_) {
+    } else if (workspace_->cand_var_vec_.empty() || *pInterrupt_) {
         setResult(-1, res);
         return;
     }
 
-    double average_info_gain = averageInfoGain();
-
     /*
      * following code is IGR weighting method
      */
+    weightCandidates();
+
+    const vector<double>& info_gain_vec  = workspace_->info_gain_vec_;
+    const vector<double>& split_info_vec = workspace_->split_info_vec_;
+    const vector<int>&    all_cand_vec   = workspace_->cand_var_vec_;
+
     double gain_ratio;
-    vector<int> cand_var_vec;
-    vector<double> cand_gain_ratio_vec;
-    for (map<int, double>::iterator iter = info_gain_map_.begin(); iter != info_gain_map_.end(); ++iter) {
-        if (iter->second >= average_info_gain) {
-            double split_info = split_info_map_[iter->first];
-            if (split_info > 0) {
-                gain_ratio = iter->second / split_info;
-                cand_var_vec.push_back(iter->first);
-                cand_gain_ratio_vec.push_back(gain_ratio);
-            }
-        }
-    }
+    vector<int>&    cand_var_vec        = workspace_->pool_vec_;
+    vector<double>& cand_gain_ratio_vec = workspace_->cand_gain_ratio_vec_;
 
     if (!isParallel_ && check_interrupt()) {
         // If run sequentially, check user interruption directly.
@@ -225,13 +683,13 @@ void C4p5Selector::doIGRSelection (VarSelectRes& res)
 
     int vindex;
     if (cand_var_vec.size() == 0) {
-        vindex = info_gain_map_.begin()->first;
-        double split_info = split_info_map_[vindex];
+        vindex = all_cand_vec.front();
+        double split_info = split_info_vec[vindex];
 
-        gain_ratio = split_info > 0 ? info_gain_map_.begin()->second / split_info : NA_REAL;
+        gain_ratio = split_info > 0 ? info_gain_vec[vindex] / split_info : NA_REAL;
     } else {
 
-        IGR igr(cand_gain_ratio_vec, mtry_, seed_, pInterrupt_, isParallel_);
+        IGR igr(cand_gain_ratio_vec, mtry_, seed_, pInterrupt_, isParallel_, workspace_);
         int index = igr.getSelectedIdx();
 
         if (!isParallel_ && check_interrupt()) {
@@ -250,15 +708,31 @@ void C4p5Selector::doIGRSelection (VarSelectRes& res)
     setResult(vindex, res, gain_ratio);
 }
 
+void C4p5Selector::calcGainRatios (vector<double>& gain_ratio_vec)
+/*
+ * Calculate the information gain ratio of each variable of this node into <gain_ratio_vec>, indexed by variable,
+ * 0 for those not worth splitting by.
+ */
+{
+    calcInfos(var_vec_);
+
+    gain_ratio_vec.assign(meta_data_->nvars(), 0);
+    if (*pInterrupt_) return;
+
+    for (int vindex : workspace_->cand_var_vec_) {
+        double split_info = workspace_->split_info_vec_[vindex];
+        if (split_info > 0) gain_ratio_vec[vindex] = workspace_->info_gain_vec_[vindex] / split_info;
+    }
+}
+
 void C4p5Selector::setResult (int vindex, VarSelectRes& result, double gain_ratio) {
     if (vindex >= 0) {
         result.ok_          = true;
         result.var_idx_     = vindex;
-        result.split_value_ = split_value_map_[vindex];
-        result.info_gain_   = info_gain_map_[vindex];
-        result.split_info_  = split_info_map_[vindex];
+        result.split_value_ = workspace_->split_value_vec_[vindex];
+        result.info_gain_   = workspace_->info_gain_vec_[vindex];
+        result.split_info_  = workspace_->split_info_vec_[vindex];
         result.gain_ratio_  = gain_ratio;
-        result.split_map_.swap(cand_splits_map_[vindex]);
     } else {
         result.ok_ = false;
     }
@@ -271,14 +745,15 @@ void C4p5Selector::doSelection (VarSelectRes& res)
  */
 {
     Sampling rs (seed_, pInterrupt_, isParallel_);
-    vector<int> subvar_vec = rs.nonReplaceRandomSample(var_vec_, mtry_);
+    vector<int>& subvar_vec = workspace_->sample_vec_;
+    rs.nonReplaceRandomSample(var_vec_, mtry_, subvar_vec, workspace_->pool_vec_);
 
     calcInfos(subvar_vec);
 
     if (!isParallel_ && check_interrupt()) {
         // If run sequentially, check user interruption directly.
         throw interrupt_exception(MODEL_INTERRUPT_MSG);
-    } else if (info_gain_map_.empty() || *pInterrupt_) {
+    } else if (workspace_->cand_var_vec_.empty() || *pInterrupt_) {
         setResult(-1, res);
         return;
     }
@@ -295,7 +770,10 @@ void C4p5Selector::findBest(VarSelectRes& res)
     double gain_ratio = -1;
     int vindex = -1;
     bool is_set_gain_ratio = false;
-    for (map<int, double>::iterator iter = info_gain_map_.begin(); iter != info_gain_map_.end(); ++iter) {
+    const vector<double>& info_gain_vec  = workspace_->info_gain_vec_;
+    const vector<double>& split_info_vec = workspace_->split_info_vec_;
+    const vector<int>&    cand_var_vec   = workspace_->cand_var_vec_;
+    for (vector<int>::const_iterator iter = cand_var_vec.begin(); iter != cand_var_vec.end(); ++iter) {
 
         if (!isParallel_ && check_interrupt()) {
             // If run sequentially, check user interruption directly.
@@ -305,18 +783,18 @@ void C4p5Selector::findBest(VarSelectRes& res)
             return;
         }
 
-        if (iter->second >= average_info_gain) {
-            double split_info = split_info_map_[iter->first];
+        if (info_gain_vec[*iter] >= average_info_gain) {
+            double split_info = split_info_vec[*iter];
             if (split_info > 0) {
-                double new_gain_ratio = iter->second / split_info;
+                double new_gain_ratio = info_gain_vec[*iter] / split_info;
                 if (is_set_gain_ratio) {
                     if (new_gain_ratio > gain_ratio) {
                         gain_ratio = new_gain_ratio;
-                        vindex     = iter->first;
+                        vindex     = *iter;
                     }
                 } else {
                     gain_ratio = new_gain_ratio;
-                    vindex     = iter->first;
+                    vindex     = *iter;
                     is_set_gain_ratio = true;
                 }
             }
@@ -324,9 +802,9 @@ void C4p5Selector::findBest(VarSelectRes& res)
     }
 
     if (!is_set_gain_ratio) {
-        vindex     = info_gain_map_.begin()->first;
-        double split_info = split_info_map_[vindex];
-        gain_ratio = split_info > 0 ? info_gain_map_.begin()->second / split_info : NA_REAL;
+        vindex     = cand_var_vec.front();
+        double split_info = split_info_vec[vindex];
+        gain_ratio = split_info > 0 ? info_gain_vec[vindex] / split_info : NA_REAL;
     }
 
     setResult(vindex, res, gain_ratio);
@@ -2,14 +2,20 @@
 #define C4_5_VAR_SELECTOR_H_
 
 #include "IGR.h"
+#include "workspace.h"
 #include "var_selector.h"
+#include "task_scheduler.h"
 
 #include <iterator>
 #include <algorithm>
+#include <atomic>
+#include <limits>
 
 class C4p5Selector: public VarSelector {
 private:
     int  min_node_size_;  // threshold for minimum child node size
+    int  nrand_splits_;   // Number of random split points tried for a continuous variable (extremely randomized trees), 0 to try all.
+    int  igr_sampsize_;   // Number of observations subsampled to estimate the weights of variables for IGR, 0 to calculate them on all.
     int  mtry_;
 
     volatile bool* pInterrupt_;
@@ -18,41 +24,64 @@ private:
     unsigned seed_;
     double   info_;  // entropy of this node
 
-    map<int, double> info_gain_map_;    // information gain for each variable
-    map<int, double> split_info_map_;   // splitinfo for each variable
-    map<int, double> split_value_map_;  // <variable> : <optimal split value>
-    map<int, map<int, vector<int> > > cand_splits_map_;  // <variable> : "<value> : <observations with that value>"
+    const vector<vector<int> >* psorted_obs_vecs_;  // Node's observations sorted by each continuous variable, NULL if not presorted.
+    map<int, vector<int> >*     phist_map_;         // <variable> : <bins * labels frequency count of the node>, NULL if not binned.
 
+    Workspace* workspace_;  // Per-thread scratch memory: information gain, split info and split value of each candidate variable, etc.
+
+    TaskScheduler*     scheduler_;          // Thread pool building the forest, to evaluate variables of large nodes in parallel, NULL if sequential.
+    vector<Workspace>* thread_workspaces_;  // Scratch memory of each thread of <scheduler_>, for the variables shared with it.
+    mutex              mut_;        // Guards the candidate variables and label histograms when evaluated in parallel.
+
+    void   setCandidate (int vindex, double info_gain, double split_info, double split_value = 0);
     void   setResult (int vindex, VarSelectRes& result, double gain_ratio = NA_REAL);
     void   calcInfos (const vector<int>& var_vec);
+    void   calcInfo (int var_idx, Workspace* ws);
     double averageInfoGain ();
+    void   weightCandidates ();
+    bool   doApproxIGRSelection (VarSelectRes& res);
 
 public:
 
-    C4p5Selector (Dataset*, TargetData*, MetaData*, int, const vector<int>&, const vector<int>&, int, unsigned, volatile bool*, bool);
+    C4p5Selector (Dataset*, TargetData*, MetaData*, int, int, int, const ObsRange&, const vector<int>&, int, unsigned, volatile bool*, bool, Workspace*,
+                  TaskScheduler* scheduler = NULL, vector<Workspace>* thread_workspaces = NULL,
+                  const vector<vector<int> >* psorted_obs_vecs = NULL, map<int, vector<int> >* phist_map = NULL);
 
-    template<class T> void handleContVar (int var_idx);
-    void handleContVar (int var_idx);
-    void handleDiscVar (int var_idx);
+    /*
+     * The handlers below use <ws> for scratch memory, which is the selector's own workspace,
+     * or a thread's workspace when evaluated in parallel.
+     */
+    template<class T> void handleContVar (int var_idx, Workspace* ws, const T* var_array);
+    template<class T> void handleRandomSplit (int var_idx, Workspace* ws, const T* var_array);
+    template<class T> void handleCountedVar (int var_idx, Workspace* ws, const T* rank_array);
+    void handleContVar (int var_idx, Workspace* ws);
+    void handleBinnedVar (int var_idx, Workspace* ws);
+    void handleDiscVar (int var_idx, Workspace* ws);
+    const vector<int>& getHistogram (int var_idx);
     void findBest(VarSelectRes& res);
     void doSelection (VarSelectRes& res);     // C4.5
     void doIGRSelection (VarSelectRes& res);  // IGR weight method
+    void calcGainRatios (vector<double>& gain_ratio_vec);
 
-    double sumNlogn (const vector<int>& dstr, int nobs) {
+    double sumNlogn (const int* dstr, int n, int nobs) {
         double sum = 0;
-        for (vector<int>::const_iterator iter = dstr.begin(); iter != dstr.end(); iter++)
+        for (const int* iter = dstr; iter != dstr + n; iter++)
             if (*iter != 0) sum += train_set_->nlogn(*iter);
 
         return train_set_->nlogn(nobs) - sum;
     }
 
-    double calcEntropy (const vector<int>& obs_vec)
+    double sumNlogn (const vector<int>& dstr, int nobs) {
+        return sumNlogn(dstr.data(), dstr.size(), nobs);
+    }
+
+    double calcEntropy (const ObsRange& obs_vec)
     /*
      * Calculate the entropy of the sub data set obs_vec.
      */
     {
-        int n = obs_vec.size();
-        return sumNlogn(targ_data_->getLabelFreqCount(obs_vec), n) / n;
+        int n = targ_data_->getLabelFreqCount(obs_vec, workspace_->label_count_vec_);
+        return sumNlogn(workspace_->label_count_vec_, n) / n;
     }
 
     double calcBisectSubinfo (const vector<int>& ldstr, int lnobs, const vector<int>& rdstr, int rnobs) {
@@ -62,18 +91,19 @@ public:
     template<class T>
     struct VarValueComparor
     /*
-     * Compare the values of variable <var_idx>, given the indexes of the observations.
+     * Compare the values, or ranks, of a variable in <var_array>, given the indexes of the observations.
+     *
+     * Ties are broken by the indexes, so that the sorted order is the same as Dataset::presort().
      */
     {
-        //TODO: Need better way to deal with different type of variable, that is DISCRETE, INTSXP, REALSXP.
-        T* var_array_;
+        const T* var_array_;
 
-        VarValueComparor (Dataset* data, int var_idx)
-            : var_array_(data->getVar<T>(var_idx)) {
+        VarValueComparor (const T* var_array)
+            : var_array_(var_array) {
         }
 
         bool operator() (int a, int b) {
-            return var_array_[a] < var_array_[b] ? true : false;
+            return var_array_[a] < var_array_[b] || (var_array_[a] == var_array_[b] && a < b);
         }
     };
 
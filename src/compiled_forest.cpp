@@ -0,0 +1,64 @@
+#include "compiled_forest.h"
+
+CompiledForest::CompiledForest (const vector<Tree*>& tree_vec, MetaData* meta_data) {
+    nlabels_ = meta_data->nlabels();
+    ntree_   = tree_vec.size();
+
+    root_vec_     = vector<int>(ntree_);
+    accuracy_vec_ = vector<double>(ntree_);
+
+    queue<Node*> untraversed_nodes;
+    for (int tindex = 0; tindex < ntree_; tindex++) {
+        Tree* tree = tree_vec[tindex];
+        root_vec_[tindex]     = kind_vec_.size();
+        accuracy_vec_[tindex] = 1 - tree->getTreeOOBErrorRate();
+
+        /*
+         * Breadth first traversal, in which a node is numbered when its parent is visited,
+         * so that the children of each node take consecutive positions.
+         */
+        int nnodes = kind_vec_.size() + 1;
+        untraversed_nodes.push(tree->getRoot());
+        while (!untraversed_nodes.empty()) {
+            Node* node = untraversed_nodes.front();
+            untraversed_nodes.pop();
+
+            if (node->type() == LEAFNODE) {
+                int leaf = leaf_label_vec_.size();
+                kind_vec_.push_back(LEAF_NODE);
+                var_idx_vec_.push_back(leaf);
+                split_value_vec_.push_back(0);
+                child_vec_.push_back(-1);
+
+                leaf_label_vec_.push_back(node->label());
+                for (int i = 0; i < nlabels_; i++)
+                    leaf_dstr_vec_.push_back(node->getLabelDstr(i));
+            } else {
+                int vindex = node->getVarIdx();
+                switch (meta_data->getVarType(vindex)) {
+                case DISCRETE:
+                    kind_vec_.push_back(DISC_NODE);
+                    split_value_vec_.push_back(0);
+                    break;
+                case INTSXP:
+                    kind_vec_.push_back(INT_NODE);
+                    split_value_vec_.push_back(node->getSplitValue());
+                    break;
+                case REALSXP:
+                    kind_vec_.push_back(REAL_NODE);
+                    split_value_vec_.push_back(node->getSplitValue());
+                    break;
+                default:
+                    throw std::range_error(meta_data->getVarName(vindex) + UNEXPECTED_VAR_TYPE_MSG);
+                }
+                var_idx_vec_.push_back(vindex);
+                child_vec_.push_back(nnodes);
+
+                int nchild = node->nchild();
+                for (int i = 0; i < nchild; i++)
+                    untraversed_nodes.push(node->getChild(i));
+                nnodes += nchild;
+            }
+        }
+    }
+}
@@ -0,0 +1,94 @@
+#ifndef COMPILED_FOREST_H_
+#define COMPILED_FOREST_H_
+
+#include "tree.h"
+
+using namespace std;
+
+class CompiledForest
+/*
+ * All the trees of a forest flattened into contiguous arrays for prediction.
+ *
+ * Nodes are stored tree by tree in breadth first order, so that the children of a node are adjacent.
+ * The type of the splitting variable is resolved into the kind of the node once,
+ * instead of being looked up in the meta data at every step of prediction.
+ */
+{
+private:
+    enum NodeKind {
+        LEAF_NODE = 0,
+        DISC_NODE = 1,  // Split by a discrete variable, one child for each value.
+        INT_NODE  = 2,  // Split by an integer variable, value <= split value goes to the first child.
+        REAL_NODE = 3   // Split by a double variable, value <= split value goes to the first child.
+    };
+
+    int nlabels_;
+    int ntree_;
+
+    vector<unsigned char> kind_vec_;         // Vector of size nnodes: Kind of each node.
+    vector<int>           var_idx_vec_;      // Vector of size nnodes: Splitting variable of internal nodes, or index of leaf nodes.
+    vector<double>        split_value_vec_;  // Vector of size nnodes: Split value for continuous variables.
+    vector<int>           child_vec_;        // Vector of size nnodes: Position of the first child of internal nodes.
+
+    vector<int>    leaf_label_vec_;  // Vector of size nleaves: Class label of each leaf node.
+    vector<double> leaf_dstr_vec_;   // Matrix of size nleaves*nlabels: Class distribution of each leaf node.
+
+    vector<int>    root_vec_;      // Vector of size ntree: Position of the root node of each tree.
+    vector<double> accuracy_vec_;  // Vector of size ntree: 1 - OOB error rate of each tree.
+
+public:
+
+    CompiledForest (const vector<Tree*>& tree_vec, MetaData* meta_data);
+
+    int ntree () const {
+        return ntree_;
+    }
+
+    size_t nbytes () const
+    /*
+     * Return the size of the arrays walked in prediction.
+     */
+    {
+        return kind_vec_.size() * (sizeof(unsigned char) + sizeof(int) + sizeof(double) + sizeof(int))
+            + leaf_label_vec_.size() * sizeof(int) + leaf_dstr_vec_.size() * sizeof(double);
+    }
+
+    int predictLeaf (Dataset* data_set, int tindex, int oindex) const
+    /*
+     * Return the index of the leaf node of tree <tindex> to which observation <oindex> belongs.
+     */
+    {
+        int node = root_vec_[tindex];
+        while (true) {
+            int vindex = var_idx_vec_[node];
+            switch (kind_vec_[node]) {
+            case LEAF_NODE:
+                return vindex;
+            case DISC_NODE:
+                node = child_vec_[node] + data_set->getValue<int>(vindex, oindex) - 1;
+                break;
+            case INT_NODE:
+                node = child_vec_[node] + ((double) data_set->getValue<int>(vindex, oindex) <= split_value_vec_[node] ? 0 : 1);
+                break;
+            default:
+                node = child_vec_[node] + (data_set->getValue<double>(vindex, oindex) <= split_value_vec_[node] ? 0 : 1);
+                break;
+            }
+        }
+    }
+
+    int getLeafLabel (int leaf) const {
+        return leaf_label_vec_[leaf];
+    }
+
+    const double* getLeafDstr (int leaf) const {
+        return &leaf_dstr_vec_[leaf * nlabels_];
+    }
+
+    double getTreeAccuracy (int tindex) const {
+        return accuracy_vec_[tindex];
+    }
+
+};
+
+#endif
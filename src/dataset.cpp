@@ -7,6 +7,8 @@ Dataset::Dataset (SEXP xSEXP, MetaData* meta_data, bool training) {
     data_ptr_vec_ = vector<void*>(ds.size());
     meta_data_    = meta_data;
 
+    level_width_vec_ = vector<int>(meta_data->nvars(), sizeof(int));
+
     if (nobs_ == 0) throw std::range_error(EMPTY_DATASET_MSG);
 
     int nvars = meta_data_->nvars();
@@ -15,15 +17,16 @@ Dataset::Dataset (SEXP xSEXP, MetaData* meta_data, bool training) {
          * For training data set.
          */
 
-        for (int i = 0; i < nvars; i++)
+        level8_vec_  = vector<vector<unsigned char> >(nvars);
+        level16_vec_ = vector<vector<unsigned short> >(nvars);
+        for (int i = 0; i < nvars; i++) {
             this->init(i, (SEXPREC*)ds[i]);
-
-        int n = 1;
-        nlogn_vec_ = vector<double>(ds.nrows()+1);
-        for (vector<double>::iterator iter = ++(nlogn_vec_.begin()); iter != nlogn_vec_.end(); iter++, n++) {
-            (*iter) = n * log((double)n) / LN_2;
+            if (meta_data_->getVarType(i) == DISCRETE) narrowLevels(i);
         }
 
+        nlogn_vec_ = vector<double>(1, 0);
+        extendNlogn(ds.nrows());
+
     } else {
         /*
          * For prediction.
@@ -46,52 +49,226 @@ Dataset::Dataset (SEXP xSEXP, MetaData* meta_data, bool training) {
 
 }
 
-map<int, vector<int> > Dataset::splitDiscVar (const vector<int>& obs_vec, int vindex)
+void Dataset::narrowLevels (int vindex)
+/*
+ * Copy the levels of discrete variable <vindex> into 1 or 2 byte codes if they fit,
+ * otherwise leave them read from the R integers.
+ */
+{
+    int  nlevels   = meta_data_->getNumValues(vindex);
+    int* var_array = getVar<int>(vindex);
+
+    if (nlevels <= numeric_limits<unsigned char>::max()) {
+        level8_vec_[vindex].assign(var_array, var_array + nobs_);
+        level_width_vec_[vindex] = sizeof(unsigned char);
+    } else if (nlevels <= numeric_limits<unsigned short>::max()) {
+        level16_vec_[vindex].assign(var_array, var_array + nobs_);
+        level_width_vec_[vindex] = sizeof(unsigned short);
+    }
+}
+
+template<class T>
+static void sortIndexByValue (vector<int>& idx_vec, T* var_array)
 /*
- * Return a mapping table which elements are
- * <value>:<index list of observations with that same value> pairs
- * where values are possible ones of that variable.
+ * Sort observation indexes in <idx_vec> by their values in <var_array>,
+ * and ties are broken by the indexes themselves.
  */
 {
+    sort(idx_vec.begin(), idx_vec.end(), [var_array](int a, int b) {
+        return var_array[a] < var_array[b] || (var_array[a] == var_array[b] && a < b);
+    });
+}
 
-    int nvals = meta_data_->getNumValues(vindex);
-    int nobs = obs_vec.size();
-    int * var_array = getVar<int>(vindex);
+void Dataset::presort ()
+/*
+ * Sort the observations once for each continuous variable,
+ * so that nodes can get their sorted orders by partitioning the parent's.
+ */
+{
+    int nvars = meta_data_->nvars();
+    sorted_idx_vec_ = vector<vector<int> >(nvars);
 
-    map<int, vector<int> > result;
+    for (int vindex = 0; vindex < nvars; vindex++) {
+        int vartype = meta_data_->getVarType(vindex);
+        if (vartype == DISCRETE) continue;
 
-    for (int i = 0; i < nvals; i++)
-        result.insert(map<int, vector<int> >::value_type(i, vector<int>()));
+        vector<int> idx_vec(nobs_);
+        for (int i = 0; i < nobs_; i++)
+            idx_vec[i] = i;
 
-    for (int i = 0; i < nobs; ++i) {
-        int val = var_array[obs_vec[i]] - 1;
-        result[val].push_back(obs_vec[i]);
+        switch (vartype) {
+        case INTSXP:
+            sortIndexByValue(idx_vec, getVar<int>(vindex));
+            break;
+        case REALSXP:
+            sortIndexByValue(idx_vec, getVar<double>(vindex));
+            break;
+        default:
+            throw std::range_error(meta_data_->getVarName(vindex) + UNEXPECTED_VAR_TYPE_MSG);
+        }
+
+        sorted_idx_vec_[vindex].swap(idx_vec);
     }
-    return result;
+}
+
+template<class T>
+static void rankColumn (vector<int>& ranks, vector<double>& values, T* var_array, int nobs)
+/*
+ * Replace the values in <var_array> by <ranks>, from 0 for the smallest, with <values> the distinct values by rank.
+ */
+{
+    vector<int> idx_vec(nobs);
+    for (int i = 0; i < nobs; i++)
+        idx_vec[i] = i;
+    sortIndexByValue(idx_vec, var_array);
 
+    ranks.resize(nobs);
+    values.clear();
+    for (int obs : idx_vec) {
+        if (values.empty() || var_array[obs] != values.back()) values.push_back(var_array[obs]);
+        ranks[obs] = values.size() - 1;
+    }
 }
 
-map<int, vector<int> > Dataset::splitPosition (vector<int>& obs_vec, int pos)
+void Dataset::rankEncode ()
 /*
- * Separate <obs_vec> into two parts,
- * and the split point is at index <pos>.
+ * Encode each continuous variable of at most 65536 distinct values by their ranks once, in 2 bytes.
+ *
+ * A variable of more distinct values keeps its values: its ranks would take 4 bytes, saving little
+ * in sorting, while taking 4 bytes for each observation and 8 for each distinct value besides the values.
  */
 {
+    int nvars = meta_data_->nvars();
+    rank_width_vec_ = vector<int>(nvars, 0);
+    rank16_vec_     = vector<vector<unsigned short> >(nvars);
+    rank_value_vec_ = vector<vector<double> >(nvars);
 
-    int nobs = obs_vec.size();
-    map<int, vector<int> > result;
-    if (pos < 0 || pos >= nobs) {
-        throw std::range_error(INER_ERR_SPLIT_MSG);
-    } else {
-        vector<int> vec0(pos + 1);
-        for (int i = 0; i <= pos; ++i)
-            vec0[i] = obs_vec[i];
-        result[0].swap(vec0);
-
-        vector<int> vec1(nobs - pos - 1);
-        for (int i = pos + 1, j = 0; i < nobs; ++i, ++j)
-            vec1[j] = obs_vec[i];
-        result[1].swap(vec1);
+    vector<int> ranks;
+    for (int vindex = 0; vindex < nvars; vindex++) {
+        switch (meta_data_->getVarType(vindex)) {
+        case DISCRETE:
+            continue;
+        case INTSXP:
+            rankColumn(ranks, rank_value_vec_[vindex], getVar<int>(vindex), nobs_);
+            break;
+        case REALSXP:
+            rankColumn(ranks, rank_value_vec_[vindex], getVar<double>(vindex), nobs_);
+            break;
+        default:
+            throw std::range_error(meta_data_->getVarName(vindex) + UNEXPECTED_VAR_TYPE_MSG);
+        }
+
+        if (rank_value_vec_[vindex].size() <= (size_t) numeric_limits<unsigned short>::max() + 1) {
+            rank16_vec_[vindex].assign(ranks.begin(), ranks.end());
+            rank_width_vec_[vindex] = sizeof(unsigned short);
+        } else {
+            vector<double>().swap(rank_value_vec_[vindex]);
+        }
+    }
+}
+
+template<class T>
+static void binColumn (vector<unsigned char>& bins, vector<double>& edges, T* var_array, int nobs, int maxbins)
+/*
+ * Quantize the values in <var_array> into at most <maxbins> bins of about equal frequency.
+ * Every distinct value has its own bin if there are no more than <maxbins> of them.
+ */
+{
+    vector<double> values(var_array, var_array + nobs);
+    sort(values.begin(), values.end());
+
+    int ndistinct = 0;
+    for (int i = 0; i < nobs; i++)
+        if (i == 0 || values[i] != values[i - 1]) ndistinct++;
+
+    edges.clear();
+    for (int i = 0; i < nobs; i++) {
+        // Close a bin at the end of a run of equal values, once it reaches the next quantile.
+        if (i + 1 < nobs && values[i + 1] == values[i]) continue;
+        if (ndistinct <= maxbins || i + 1 == nobs || i + 1 >= (edges.size() + 1) * (double)nobs / maxbins)
+            edges.push_back(values[i]);
+    }
+
+    bins = vector<unsigned char>(nobs);
+    for (int i = 0; i < nobs; i++)
+        bins[i] = distance(edges.begin(), lower_bound(edges.begin(), edges.end(), (double)var_array[i]));
+}
+
+void Dataset::bin (int maxbins)
+/*
+ * Quantize each continuous variable once into at most <maxbins> (<= 255) bins,
+ * so that split search scans label histograms over bins instead of sorted observations.
+ */
+{
+    int nvars = meta_data_->nvars();
+    bin_vec_      = vector<vector<unsigned char> >(nvars);
+    bin_edge_vec_ = vector<vector<double> >(nvars);
+
+    for (int vindex = 0; vindex < nvars; vindex++) {
+        switch (meta_data_->getVarType(vindex)) {
+        case DISCRETE:
+            break;
+        case INTSXP:
+            binColumn(bin_vec_[vindex], bin_edge_vec_[vindex], getVar<int>(vindex), nobs_, maxbins);
+            break;
+        case REALSXP:
+            binColumn(bin_vec_[vindex], bin_edge_vec_[vindex], getVar<double>(vindex), nobs_, maxbins);
+            break;
+        default:
+            throw std::range_error(meta_data_->getVarName(vindex) + UNEXPECTED_VAR_TYPE_MSG);
+        }
+    }
+}
+
+void Dataset::extendNlogn (int n)
+/*
+ * Extend the table of N*log(N) to all N in [1, n], as a node may hold more than nrows copies
+ * when drawn with replacement.
+ */
+{
+    int m = nlogn_vec_.size();
+    if (n < m) return;
+
+    nlogn_vec_.resize(n + 1);
+    for (int i = m; i <= n; i++)
+        nlogn_vec_[i] = i * log((double)i) / LN_2;
+}
+
+int Dataset::markChildren (const ObsRange& obs_vec, int vindex, double split_value, vector<int>& child_mark)
+/*
+ * Mark the child node each observation in <obs_vec> goes to, when split by variable <vindex>,
+ * the same way as a tree node does in prediction.
+ *
+ * Return the number of child nodes.
+ */
+{
+    switch (getRankWidth(vindex)) {
+    case sizeof(unsigned short):
+        markByValue(obs_vec, getRanks<unsigned short>(vindex), getRankBound(vindex, split_value), child_mark);
+        return 2;
+    }
+
+    switch (meta_data_->getVarType(vindex)) {
+    case DISCRETE:
+        switch (getLevelWidth(vindex)) {
+        case sizeof(unsigned char):
+            markByLevel(obs_vec, getLevels<unsigned char>(vindex), child_mark);
+            break;
+        case sizeof(unsigned short):
+            markByLevel(obs_vec, getLevels<unsigned short>(vindex), child_mark);
+            break;
+        default:
+            markByLevel(obs_vec, getLevels<int>(vindex), child_mark);
+            break;
+        }
+        return meta_data_->getNumValues(vindex);
+    case INTSXP:
+        markByValue(obs_vec, getVar<int>(vindex), split_value, child_mark);
+        return 2;
+    case REALSXP:
+        markByValue(obs_vec, getVar<double>(vindex), split_value, child_mark);
+        return 2;
+    default:
+        throw std::range_error(meta_data_->getVarName(vindex) + UNEXPECTED_VAR_TYPE_MSG);
     }
-    return result;
 }
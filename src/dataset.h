@@ -4,6 +4,9 @@
 #include "utility.h"
 #include "meta_data.h"
 
+#include <limits>
+#include <algorithm>
+
 using namespace std;
 
 class TargetData
@@ -18,6 +21,8 @@ private:
 
     Rcpp::IntegerVector data_;  // raw data Rcpp wrapper
 
+    vector<vector<int> > label_obs_vec_;  // Observations of each class label, empty if not grouped.
+
 public:
     TargetData (SEXP ySEXP) {
         data_    = Rcpp::as<Rcpp::IntegerVector>(ySEXP);
@@ -52,7 +57,25 @@ public:
         return targ_array_[index];
     }
 
-    bool haveSameLabel (const vector<int>& obs_vec) {
+    void groupByLabel ()
+    /*
+     * Group the observations by class label once, for stratified sampling.
+     */
+    {
+        label_obs_vec_ = vector<vector<int> >(nlabels_);
+        for (int i = 0; i < nobs_; i++)
+            label_obs_vec_[targ_array_[i] - 1].push_back(i);
+    }
+
+    const vector<int>& getLabelObs (int label) const
+    /*
+     * Observations with class label <label>, counted from 0, in ascending order.  See groupByLabel().
+     */
+    {
+        return label_obs_vec_[label];
+    }
+
+    bool haveSameLabel (const ObsRange& obs_vec) {
         // Whether all observations in <obs_vec> have the same class label.
         int nobs = obs_vec.size();
         if (nobs == 0) {
@@ -67,19 +90,52 @@ public:
         }
     }
 
-    vector<int> getLabelFreqCount (const vector<int>& obs_vec)
+    vector<int> getLabelFreqCount (const ObsRange& obs_vec)
     /*
      * Class label frequency count.
-     * That is, how many observations have a specific class label.
+     * That is, how many observations have a specific class label, counting bootstrap copies.
      */
     {
-        int nobs = obs_vec.size();
-        vector<int> numbers (nlabels_, 0);
+        vector<int> numbers;
+        getLabelFreqCount(obs_vec, numbers);
+        return numbers;
+    }
 
-        for (int i = 0; i < nobs; i++)
-            numbers[targ_array_[obs_vec[i]] - 1]++;
+    int getLabelFreqCount (const ObsRange& obs_vec, vector<int>& numbers)
+    /*
+     * The same as above, but count into <numbers> to avoid allocation, and return the total count.
+     */
+    {
+        int nobs = obs_vec.size();
+        int total = 0;
+        numbers.assign(nlabels_, 0);
+
+        for (int i = 0; i < nobs; i++) {
+            int obs = obs_vec[i];
+            int n = obs_vec.count(obs);
+            numbers[targ_array_[obs] - 1] += n;
+            total += n;
+        }
+        return total;
+    }
 
-        return numbers;
+    template<class T>
+    void getLevelLabelFreqCount (const ObsRange& obs_vec, const T* var_array, int nlevels, vector<int>& table, vector<int>& level_counts)
+    /*
+     * Contingency table of a discrete variable of <nlevels> levels, whose values are in <var_array>, against the labels,
+     * counted in one pass: <table> is a matrix of size nlevels*nlabels, a row for each level,
+     * and <level_counts> is the number of copies of each level.
+     */
+    {
+        table.assign(nlevels * nlabels_, 0);
+        level_counts.assign(nlevels, 0);
+
+        for (int obs : obs_vec) {
+            int level = var_array[obs] - 1;
+            int n = obs_vec.count(obs);
+            table[level * nlabels_ + targ_array_[obs] - 1] += n;
+            level_counts[level] += n;
+        }
     }
 
     Rcpp::List save () {
@@ -100,7 +156,30 @@ private:
     int              nobs_;          // The total number of observations in the training set.
     bool             training_;      // Training set or not?
 
-    vector<double>   nlogn_vec_;     // The value of N*log(N) for all N in [1, nrows].
+    vector<double>   nlogn_vec_;     // The value of N*log(N) for all N in [1, nrows], or up to the sample size if larger.
+
+    vector<vector<int> > sorted_idx_vec_;  // Observation indexes sorted by value for each continuous variable, empty if not presorted.
+
+    vector<vector<unsigned char> > bin_vec_;       // Bin codes of the observations for each continuous variable, empty if not binned.
+    vector<vector<double> >        bin_edge_vec_;  // Upper edges of the bins for each continuous variable.
+
+    /*
+     * Discrete variables of the training set are copied into the narrowest codes fitting their levels,
+     * so that split search reads 1 or 2 bytes per observation instead of an R integer.
+     */
+    vector<int>                     level_width_vec_;  // Bytes of a level of each variable: 1 or 2 if narrowed, sizeof(int) if read from R.
+    vector<vector<unsigned char> >  level8_vec_;       // Levels of the discrete variables of at most 255 levels, empty for the others.
+    vector<vector<unsigned short> > level16_vec_;      // Levels of the discrete variables of at most 65535 levels, empty for the others.
+
+    void narrowLevels (int vindex);
+
+    /*
+     * Continuous variables of the training set may be replaced by the ranks of their distinct values,
+     * so that split search sorts and compares 2 byte integers, and looks up the values only for the splits.
+     */
+    vector<int>                     rank_width_vec_;  // Bytes of a rank of each variable: 2 if rank encoded, 0 if not.
+    vector<vector<unsigned short> > rank16_vec_;      // Ranks of the variables of at most 65536 distinct values, empty for the others.
+    vector<vector<double> >         rank_value_vec_;  // Distinct values of each rank encoded variable in ascending order, indexed by rank.
 
     vector<Rcpp::IntegerVector> preserve_int;
     vector<Rcpp::NumericVector> preserve_num;
@@ -186,6 +265,8 @@ public:
         return nlogn_vec_[n];
     }
 
+    void extendNlogn (int n);
+
     int nobs () const {
         return nobs_;
     }
@@ -206,8 +287,124 @@ public:
         return getVar<T>(vindex)[oindex];
     }
 
-    map<int, vector<int> > splitDiscVar (const vector<int>&, int);
-    map<int, vector<int> > splitPosition (vector<int>&, int);
+    double getNumValue (int vindex, int oindex) {
+        // The value of continuous variable <vindex> of observation <oindex>, whatever its type.
+        return meta_data_->getVarType(vindex) == INTSXP ? getValue<int>(vindex, oindex) : getValue<double>(vindex, oindex);
+    }
+
+    int getLevelWidth (int vindex) const {
+        return level_width_vec_[vindex];
+    }
+
+    template<class T>
+    const T* getLevels (int vindex) const;  // Levels of discrete variable <vindex>, of the width given by getLevelWidth().
+
+    int getRankWidth (int vindex) const {
+        return rank_width_vec_.empty() ? 0 : rank_width_vec_[vindex];
+    }
+
+    template<class T>
+    const T* getRanks (int vindex) const;  // Ranks of continuous variable <vindex>, of the width given by getRankWidth().
+
+    int getNumRanks (int vindex) const {
+        return rank_value_vec_[vindex].size();
+    }
+
+    int getRankBound (int vindex, double value) const
+    /*
+     * The largest rank of variable <vindex> whose value is no greater than <value>, -1 if none,
+     * so that comparing ranks with it is the same as comparing values with <value>.
+     */
+    {
+        const vector<double>& values = rank_value_vec_[vindex];
+        return upper_bound(values.begin(), values.end(), value) - values.begin() - 1;
+    }
+
+    void rankEncode ();
+
+    bool isPresorted () const {
+        return !sorted_idx_vec_.empty();
+    }
+
+    const vector<int>& getSortedIndex (int vindex) const
+    /*
+     * Indexes of all the observations in ascending order of variable <vindex>,
+     * ties broken by observation index.
+     */
+    {
+        return sorted_idx_vec_[vindex];
+    }
+
+    void presort ();
+
+    bool isBinned () const {
+        return !bin_vec_.empty();
+    }
+
+    int getNumBins (int vindex) const {
+        return bin_edge_vec_[vindex].size();
+    }
+
+    const unsigned char* getBins (int vindex) const
+    /*
+     * Bin codes of all the observations for variable <vindex>.
+     */
+    {
+        return bin_vec_[vindex].data();
+    }
+
+    double getBinEdge (int vindex, int bin) const
+    /*
+     * The largest value falling into bin <bin> of variable <vindex>.
+     */
+    {
+        return bin_edge_vec_[vindex][bin];
+    }
+
+    void bin (int maxbins);
+
+    int markChildren (const ObsRange&, int, double, vector<int>&);
+
+    template<class T>
+    static void markByValue (const ObsRange& obs_vec, const T* var_array, double split_value, vector<int>& child_mark)
+    /*
+     * Mark observations with values no greater than <split_value> as going to child 0, the rest to child 1.
+     */
+    {
+        for (int obs : obs_vec)
+            child_mark[obs] = var_array[obs] <= split_value ? 0 : 1;
+    }
+
+    template<class T>
+    static void markByLevel (const ObsRange& obs_vec, const T* var_array, vector<int>& child_mark)
+    /*
+     * Mark observations as going to the child of their levels.
+     */
+    {
+        for (int obs : obs_vec)
+            child_mark[obs] = var_array[obs] - 1;
+    }
 
 };
+
+template<>
+inline const unsigned char* Dataset::getLevels<unsigned char> (int vindex) const {
+    return level8_vec_[vindex].data();
+}
+
+template<>
+inline const unsigned short* Dataset::getLevels<unsigned short> (int vindex) const {
+    return level16_vec_[vindex].data();
+}
+
+template<>
+inline const int* Dataset::getLevels<int> (int vindex) const {
+    return (const int*)(data_ptr_vec_[vindex]);
+}
+
+template<>
+inline const unsigned short* Dataset::getRanks<unsigned short> (int vindex) const {
+    return rank16_vec_[vindex].data();
+}
+
 #endif
@@ -46,6 +46,14 @@ public:
         return iter->second.size();
     }
 
+    int maxNumChildren () const {
+        // The largest number of children of a node, split by the discrete variable of most values or into two.
+        int res = 2;
+        for (int i = 0; i < nvars_; i++)
+            if (var_types_[i] == DISCRETE) res = max(res, getNumValues(i));
+        return res;
+    }
+
     int nlabels() const {
         // The number of class labels.
         return nlabels_;
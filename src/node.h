@@ -6,6 +6,7 @@
 #include <sstream>
 
 #include "meta_data.h"
+#include "node_arena.h"
 
 class Node {
 private:
@@ -23,7 +24,8 @@ private:
     double split_info_;   // Split Info = - \sum\frac{nobs_{child}}{nobs_} \times \log_2\frac{nobs_{child}}{nobs_}
     double gain_ratio_;   // Information Gain Ratio = Information Gain / Split Info
 
-    vector<Node*> child_nodes_;  // Children nodes of this node.
+    Node** child_nodes_;  // Children nodes of this node, allocated in the arena of the tree.
+    int    nchild_;       // The number of children nodes.
 
     /*
      * following attributes are for leaf node
@@ -31,20 +33,26 @@ private:
 
     int label_;   // class label of the leaf node
 
-    vector<int>    label_freq_count_;    // The numbers of observations belong to each label.
-    vector<double> label_distribution_;  // = label_freq_count_ / nobs_
+    int* label_freq_count_;  // The numbers of observations belong to each label, allocated in the arena of the tree.
+    int  nlabels_;           // The size of label_freq_count_.
+    int  dstr_nobs_;         // label_distribution = label_freq_count_ / dstr_nobs_
 
 public:
 
-    Node (NodeType type, int nobs, int nchild = 0) {
+    Node (NodeArena& arena, NodeType type, int nobs, int nchild = 0) {
         type_ = type;
         nobs_ = nobs;
 
         // If it is internal node, initialize children node vector.
-        if (nchild != 0) child_nodes_ = vector<Node*>(nchild);
+        nchild_      = nchild;
+        child_nodes_ = arena.newArray<Node*>(nchild);
+
+        label_freq_count_ = NULL;
+        nlabels_          = 0;
+        dstr_nobs_        = 0;
     }
 
-    Node (const vector<double>& node_info, MetaData* meta_data) {
+    Node (NodeArena& arena, const vector<double>& node_info, MetaData* meta_data) {
         /*
          * Reconstruct Node
          * see "Node::save ()" for details
@@ -55,16 +63,23 @@ public:
         type_ = (NodeType) (*iter++);
         nobs_ = *iter++;
 
+        nchild_           = 0;
+        child_nodes_      = NULL;
+        label_freq_count_ = NULL;
+        nlabels_          = 0;
+        dstr_nobs_        = 0;
+
         if (type_ == LEAFNODE) {
 
             label_ = *iter++;
 
-            while (iter != node_info.end())
-                label_freq_count_.push_back(*iter++);
+            vector<int> label_nums(iter, node_info.end());
+            setLabelFreqCount(arena, label_nums);
 
         } else {
 
-            child_nodes_ = vector<Node*>((int) (*iter++));
+            nchild_      = *iter++;
+            child_nodes_ = arena.newArray<Node*>(nchild_);
             var_idx_     = *iter++;
             info_gain_   = *iter++;
             split_info_  = *iter++;
@@ -122,16 +137,23 @@ public:
     }
 
     int nchild () {
-        return child_nodes_.size();
+        return nchild_;
     }
 
-    void setLabelFreqCount (vector<int> label_nums, bool set_label = false) {
+    void setLabelFreqCount (NodeArena& arena, const vector<int>& label_nums, bool set_label = false) {
         // If set_label = true, calculate and set the major label from label frequency count.
         // Otherwise, just set the label frequency count.
 
-        label_freq_count_.swap(label_nums);
+        nlabels_          = label_nums.size();
+        label_freq_count_ = arena.newArray<int>(nlabels_);
+        copy(label_nums.begin(), label_nums.end(), label_freq_count_);
 
-        if (set_label) label_ = distance(label_freq_count_.begin(), max_element(label_freq_count_.begin(), label_freq_count_.end()));
+        dstr_nobs_ = nobs_;
+        if (dstr_nobs_ == 0)
+            for (int i = 0; i < nlabels_; i++)
+                dstr_nobs_ += label_freq_count_[i];
+
+        if (set_label) label_ = distance(label_freq_count_, max_element(label_freq_count_, label_freq_count_ + nlabels_));
     }
 
     void setChild (int index, Node* node) {
@@ -142,25 +164,12 @@ public:
         return child_nodes_[index];
     }
 
-    vector<double> getLabelDstr () {
+    double getLabelDstr (int label) {
+        // The proportion of observations with class label <label> in the leaf node.
 
         if (type_ != LEAFNODE) throw range_error(INER_ERR_NON_LEAF_NODE_MSG);
 
-        if (label_distribution_.size() <= 0) {
-            int n = label_freq_count_.size();
-            label_distribution_ = vector<double>(n);
-
-            int nobs = nobs_;
-            if (nobs == 0)
-                for (int i = 0; i < n; i++)
-                    nobs += label_freq_count_[i];
-
-            for (int i = 0; i < n; i++)
-                label_distribution_[i] = label_freq_count_[i] / (double) nobs;
-
-        }
-
-        return label_distribution_;
+        return label_freq_count_[label] / (double) dstr_nobs_;
     }
 
     string getLabelDstrStr ()
@@ -168,15 +177,14 @@ public:
      * For printing the class distribution in the leaf node.
      */
     {
-        vector<double> dstr = getLabelDstr();
         stringstream res;
         res.precision(2);
 
-        int n = dstr.size() - 1;
+        int n = nlabels_ - 1;
         for (int i = 0; i < n; i++)
-            res << dstr[i] << " ";
+            res << getLabelDstr(i) << " ";
 
-        res << dstr[n];
+        res << getLabelDstr(n);
 
         return res.str();
     }
@@ -207,13 +215,12 @@ public:
 
             node_info.push_back(label_);
 
-            int n = label_freq_count_.size();
-            for (int i = 0; i < n; i++)
+            for (int i = 0; i < nlabels_; i++)
                 node_info.push_back(label_freq_count_[i]);
 
         } else {
 
-            node_info.push_back(child_nodes_.size());
+            node_info.push_back(nchild_);
             node_info.push_back(var_idx_);
             node_info.push_back(info_gain_);
             node_info.push_back(split_info_);
@@ -0,0 +1,111 @@
+#ifndef NODE_ARENA_H_
+#define NODE_ARENA_H_
+
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+using namespace std;
+
+class NodeArena
+/*
+ * Memory of the nodes of a tree, including their child node pointers and label frequency counts.
+ *
+ * Objects are carved out of a few large blocks, and freed all at once when the arena is destroyed,
+ * so only trivially destructible objects are allowed.
+ */
+{
+private:
+    static const size_t BLOCK_SIZE = 64 * 1024;  // Bytes of a regular block.
+    static const size_t ALIGNMENT  = alignof(max_align_t);
+
+    vector<void*> blocks_;  // All the blocks allocated.
+    char*  cur_;            // Next free byte in the current block.
+    size_t left_;           // Free bytes left in the current block.
+
+    void* allocate (size_t size) {
+        size = (size + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT;
+
+        if (size > left_) {
+            if (size > BLOCK_SIZE / 4) {
+                // Large request gets its own block, keeping the current one.
+                return newBlock(size);
+            }
+            cur_  = (char*) newBlock(BLOCK_SIZE);
+            left_ = BLOCK_SIZE;
+        }
+
+        void* p = cur_;
+        cur_  += size;
+        left_ -= size;
+        return p;
+    }
+
+    void* newBlock (size_t size) {
+        void* block = malloc(size);
+        if (block == NULL) throw bad_alloc();
+        blocks_.push_back(block);
+        return block;
+    }
+
+    NodeArena (const NodeArena&);
+    NodeArena& operator= (const NodeArena&);
+
+public:
+
+    NodeArena () {
+        cur_  = NULL;
+        left_ = 0;
+    }
+
+    ~NodeArena () {
+        clear();
+    }
+
+    template<class T, class... Args>
+    T* create (Args&&... args)
+    /*
+     * Construct an object of type <T> in the arena.
+     */
+    {
+        static_assert(is_trivially_destructible<T>::value, "Objects in NodeArena are never destroyed");
+        return new (allocate(sizeof(T))) T(std::forward<Args>(args)...);
+    }
+
+    template<class T>
+    T* newArray (int n)
+    /*
+     * Allocate an array of <n> zero initialized elements of type <T> in the arena.
+     */
+    {
+        static_assert(is_trivially_destructible<T>::value, "Objects in NodeArena are never destroyed");
+        if (n <= 0) return NULL;
+
+        T* array = (T*) allocate(n * sizeof(T));
+        for (int i = 0; i < n; i++)
+            new (array + i) T();
+        return array;
+    }
+
+    void clear ()
+    /*
+     * Free all the memory in one go.
+     */
+    {
+        for (void* block : blocks_)
+            free(block);
+        vector<void*>().swap(blocks_);
+        cur_  = NULL;
+        left_ = 0;
+    }
+
+    size_t nblocks () const {
+        return blocks_.size();
+    }
+
+};
+
+#endif
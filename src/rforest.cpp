@@ -7,8 +7,21 @@ RForest::RForest (
         int ntree,
         int nvars,
         int min_node_size,
+        int max_depth,
+        int max_nodes,
+        int max_leaves,
+        double min_gain,
+        int nrand_splits,
+        int igr_sampsize,
+        int screen_nvars,
+        double screen_ratio,
         bool weights,
         bool importance,
+        bool presort,
+        bool rank_encode,
+        int maxbins,
+        const vector<int>& sampsize,
+        bool replace,
         SEXP seeds,
         volatile bool* pInterrupt)
 /*
@@ -22,34 +35,61 @@ RForest::RForest (
     ntree_             = ntree;
     mtry_              = nvars;
     min_node_size_     = min_node_size;
+    max_depth_         = max_depth;
+    max_nodes_         = max_nodes;
+    max_leaves_        = max_leaves;
+    min_gain_          = min_gain;
+    nrand_splits_      = nrand_splits;
+    igr_sampsize_      = igr_sampsize;
+    screen_nvars_      = screen_nvars;
+    screen_ratio_      = screen_ratio;
+    feature_vars_      = meta_data->getFeatureVars();
     weights_           = weights;
     tree_seeds_        = (unsigned int*) INTEGER(seeds);
     nlabels_           = meta_data->nlabels();
     importance_        = importance;
+    presort_           = presort && maxbins == 0 && nrand_splits == 0;  // Binned variables and random splits need no sorting.
+    maxbins_           = nrand_splits == 0 ? maxbins : 0;            // Random splits need no histograms.
+    sampsize_          = sampsize;
+    replace_           = replace;
     rf_strength_       = NA_REAL;
     rf_correlation_    = NA_REAL;
     rf_oob_error_rate_ = NA_REAL;
     c_s2_              = NA_REAL;
     emr2_              = NA_REAL;
 
+    compiled_forest_   = NULL;
+
     pInterrupt_ = pInterrupt;
     isParallel_ = false;
 
     tree_vec_    = vector<Tree*>(ntree);
-    bagging_set_ = vector<vector<int> >(ntree, vector<int>(train_set->nobs(), -1));
     oob_set_vec_ = vector<vector<int> >(ntree);
 
-    if (mtry_ == -1) mtry_ = log((double)(meta_data_->nvars()))/LN_2 + 1;
+    if (mtry_ == -1 && screen_nvars_ <= 0 && screen_ratio_ < 0) mtry_ = log((double)(meta_data_->nvars()))/LN_2 + 1;
+
+    if (rank_encode && maxbins_ == 0 && nrand_splits_ == 0) train_set_->rankEncode();  // Only the search for the best split reads ranks.
+    if (presort_) train_set_->presort();
+    if (sampsize_.size() > 1) targ_data_->groupByLabel();
+    int ndraws = accumulate(sampsize_.begin(), sampsize_.end(), 0);
+    if (ndraws > train_set_->nobs()) train_set_->extendNlogn(ndraws);
+    if (maxbins_ > 0) train_set_->bin(maxbins_);
 }
 
-RForest::RForest (Rcpp::List& wsrf_R, MetaData* meta_data, TargetData* targdata)
+RForest::RForest (Rcpp::List& wsrf_R, MetaData* meta_data, TargetData* targdata, bool predict_only)
 /*
  * Construct forest from R.
  *
  * For merge, split and prediction.
+ *
+ * If <predict_only>, the trees are compiled right away and released,
+ * and nothing else than needed for prediction is read.
  */
 {
     importance_        = false;
+    presort_           = false;
+    maxbins_           = 0;
+    replace_           = true;
     tree_seeds_        = NULL;
     rf_strength_       = NA_REAL;
     rf_correlation_    = NA_REAL;
@@ -59,8 +99,17 @@ RForest::RForest (Rcpp::List& wsrf_R, MetaData* meta_data, TargetData* targdata)
     mtry_              = -1;
     weights_           = false;
     min_node_size_     = 2;
+    max_depth_         = 0;
+    max_nodes_         = 0;
+    max_leaves_        = 0;
+    min_gain_          = 0;
+    nrand_splits_      = 0;
+    igr_sampsize_      = 0;
+    screen_nvars_      = 0;
+    screen_ratio_      = -1;
     pInterrupt_        = NULL;
     isParallel_        = false;
+    compiled_forest_   = NULL;
 
     train_set_ = NULL;
     targ_data_ = targdata;
@@ -80,6 +129,14 @@ RForest::RForest (Rcpp::List& wsrf_R, MetaData* meta_data, TargetData* targdata)
         tree_vec_[i] = tree;
     }
 
+    if (predict_only) {
+        compile();
+        for (int i = 0; i < ntree_; i++)
+            delete tree_vec_[i];
+        vector<Tree*>().swap(tree_vec_);
+        return;
+    }
+
     oob_set_vec_ = Rcpp::as<vector<vector<int> > >((SEXPREC*)wsrf_R[OOB_SETS_IDX]);
 
     vector<vector<int> >    oob_predict_label_set_vec = Rcpp::as<vector<vector<int> > >((SEXPREC*)wsrf_R[OOB_PREDICT_LABELS_IDX]);
@@ -105,20 +162,89 @@ RForest::~RForest () {
             if (tree) delete tree;
         }
     }
+
+    if (compiled_forest_) delete compiled_forest_;
 }
 
-void RForest::buildOneTree (int ind) {
+const CompiledForest& RForest::compile ()
+/*
+ * Flatten the trees for prediction, once for all.
+ */
+{
+    if (compiled_forest_ == NULL) compiled_forest_ = new CompiledForest(tree_vec_, meta_data_);
+    return *compiled_forest_;
+}
+
+void RForest::screenVars (Workspace* workspace, TaskScheduler* scheduler, vector<Workspace>* thread_workspaces)
+/*
+ * Root-level feature screening: calculate the information gain ratio of each variable once on the whole
+ * training set, with the variables shared among the threads of <scheduler> if any, and keep as candidates
+ * for all trees only the <screen_nvars_> variables of the highest ratios, and those no less than <screen_ratio_>.
+ *
+ * If <mtry_> is -1, it is set by the number of variables kept, as it would be by all the variables without screening.
+ */
+{
+    if (screen_nvars_ <= 0 && screen_ratio_ < 0) return;
+
+    int nobs = train_set_->nobs();
+    vector<int> obs_vec(nobs);
+    vector<int> obs_count(nobs, 1);
+    iota(obs_vec.begin(), obs_vec.end(), 0);
+    ObsRange obs_range(obs_vec, obs_count.data());
+
+    const vector<int>& all_vars = meta_data_->getFeatureVars();
+    C4p5Selector selector(train_set_, targ_data_, meta_data_, min_node_size_, 0, 0, obs_range, all_vars, mtry_, 0,
+            pInterrupt_, isParallel_, workspace, scheduler, thread_workspaces);
+    selector.calcGainRatios(screen_ratio_vec_);
+
+    if (!isParallel_ && check_interrupt()) {
+        // If run sequentially, check user interruption directly.
+        throw interrupt_exception(MODEL_INTERRUPT_MSG);
+    } else if (*pInterrupt_) {
+        return;
+    }
+
+    // Rank by descending ratio, ties by variable index.
+    vector<int> ranked_vars(all_vars);
+    stable_sort(ranked_vars.begin(), ranked_vars.end(), [this] (int a, int b) { return screen_ratio_vec_[a] > screen_ratio_vec_[b]; });
+
+    feature_vars_.clear();
+    for (int vindex : ranked_vars) {
+        if (screen_nvars_ > 0 && (int) feature_vars_.size() >= screen_nvars_) break;
+        if (screen_ratio_ >= 0 && screen_ratio_vec_[vindex] < screen_ratio_) break;
+        feature_vars_.push_back(vindex);
+    }
+    if (feature_vars_.empty()) throw std::range_error(NO_SCREENED_VAR_MSG);
+
+    sort(feature_vars_.begin(), feature_vars_.end());
+
+    if (mtry_ == -1) mtry_ = log((double)(feature_vars_.size()))/LN_2 + 1;
+}
+
+void RForest::buildOneTree (int ind, Workspace* workspace, TaskScheduler* scheduler, vector<Workspace>* thread_workspaces) {
     Tree* decision_tree = new Tree(
             train_set_,
             targ_data_,
             meta_data_,
             min_node_size_,
+            max_depth_,
+            max_nodes_,
+            max_leaves_,
+            min_gain_,
+            nrand_splits_,
+            igr_sampsize_,
             tree_seeds_[ind],
-            &(bagging_set_[ind]),
             &(oob_set_vec_[ind]),
+            &sampsize_,
+            replace_,
             mtry_,
+            &feature_vars_,
             weights_,
             importance_,
+            presort_,
+            workspace,
+            scheduler,
+            thread_workspaces,
             pInterrupt_,
             isParallel_);
     decision_tree->build();
@@ -131,11 +257,13 @@ void RForest::buidForestSeq ()
  */
 {
     isParallel_ = false;
+    Workspace workspace(meta_data_->nvars(), nlabels_, meta_data_->maxNumChildren());
+    screenVars(&workspace);
     for (int ind = 0; ind < ntree_; ind++) {
         // check interruption
         if (check_interrupt()) throw interrupt_exception(MODEL_INTERRUPT_MSG);
 
-        buildOneTree(ind);
+        buildOneTree(ind, &workspace);
     }
 }
 
@@ -159,88 +287,137 @@ void RForest::buildForestAsync (int parallel)
         nThreads = parallel;
     }
 
-    // using <nThreads> tree builder to build trees
-    int index = 0;
-    vector<future<void> > results(nThreads);
-    this->tree_vec_ = vector<Tree*>(this->ntree_);
+    // Each tree is a task, run by <nThreads> threads with their own workspace.
+    // A thread only ever works in its own workspace, also when helping another task,
+    // so the screening runs in the pool as well.
+    // They are constructed in place, as copies would not keep the capacity reserved.
+    vector<Workspace> workspaces;
+    workspaces.reserve(nThreads);
     for (int i = 0; i < nThreads; i++)
-        results[i] = async(launch::async, &RForest::buildOneTreeAsync, this, &index);
+        workspaces.emplace_back(meta_data_->nvars(), nlabels_, meta_data_->maxNumChildren());
+    this->tree_vec_ = vector<Tree*>(this->ntree_);
 
-    try {
+    // Threads left idle by the last trees help with the large nodes of the others.
+    TaskScheduler scheduler(nThreads, pInterrupt_);
+    scheduler.submit([this, &workspaces, &scheduler] (int tindex) { screenVars(&workspaces[tindex], &scheduler, &workspaces); });
+    scheduler.wait();
+    if (*pInterrupt_) return;
+    for (int ind = 0; ind < ntree_; ind++)
+        scheduler.submit([this, ind, &workspaces, &scheduler] (int tindex) { buildOneTree(ind, &workspaces[tindex], &scheduler, &workspaces); });
+
+    // Sleep until all trees are built, or rethrow the first exception from tree builders,
+    // in which case the others have been informed by <pInterrupt_> and finished.
+    scheduler.wait();
+}
 
-        int i = 0;
-        do {
-            // check each tree builder's status till all are finished
-            for (int j = 0; j < nThreads; j++) {
-#if (defined(__GNUC__) && ((__GNUC__ == 4 && __GNUC_MINOR__ >= 7) || (__GNUC__ >= 5))) || defined(__clang__)
-                if (results[j].valid() && results[j].wait_for(chrono::seconds {0}) == future_status::ready) {
-#else
-                if (results[j].valid() && results[j].wait_for(chrono::seconds {0})) {
-#endif
-                    results[j].get();  // May throw exception.
-                    i++;
-                } // if ()
-            } // for ()
-        } while (i < nThreads);
+void RForest::predictBlock (const CompiledForest& forest, Dataset* data, int begin, int end, int type, int* class_iter, double** res_iter)
+/*
+ * Predict observations [begin, end) of <data>, and write into the corresponding elements (columns) of
+ * <class_iter> and the matrices in <res_iter> required by <type>.
+ *
+ * The whole block is pushed through one tree before the next, so that a tree stays in cache for the block,
+ * unless the forest is smaller than <PRED_BLOCK_MIN_BYTES>.  Each observation still accumulates the trees
+ * in the same order as predicting it alone.
+ */
+{
+    bool need_class  = type & PRED_TYPE_CLASS;
+    bool need_prob   = type & PRED_TYPE_PROB;
+    bool need_aprob  = type & PRED_TYPE_APROB;
+    bool need_waprob = type & PRED_TYPE_WAPROB;
+    bool need_vote   = (type & PRED_TYPE_VOTE) || need_class;
 
-    } catch (...) {  // Only exception from sub-threads, except user interruption.
+    double* vote   = need_vote   ? res_iter[PRED_TYPE_VOTE_IDX]   + begin * nlabels_ : NULL;
+    double* prob   = need_prob   ? res_iter[PRED_TYPE_PROB_IDX]   + begin * nlabels_ : NULL;
+    double* aprob  = need_aprob  ? res_iter[PRED_TYPE_APROB_IDX]  + begin * nlabels_ : NULL;
+    double* waprob = need_waprob ? res_iter[PRED_TYPE_WAPROB_IDX] + begin * nlabels_ : NULL;
 
-        // If one tree builder throw a exception, set true to inform others.
-        (*pInterrupt_) = true;
+    int nobs = end - begin;
+    double sumAccuracy = 0;
+    for (int tree_idx = 0; tree_idx < forest.ntree(); ++tree_idx)
+        sumAccuracy += forest.getTreeAccuracy(tree_idx);
 
-        // Wait for other threads to finish.
-        for (int i = 0; i < nThreads; i++) {
-            if (results[i].valid())
-                results[i].wait();
-        }
+    // Get leaf node information.
+    auto addLeaf = [&] (int tree_idx, int i) {
+        int offset = i * nlabels_;
+        int leaf   = forest.predictLeaf(data, tree_idx, begin + i);
+        int label  = forest.getLeafLabel(leaf);
 
-        rethrow_exception(current_exception());
+        if (need_vote) vote[offset + label]++;  // vote or class
 
-    } // try-catch
+        if (need_prob) prob[offset + label]++;  // prob
 
-}
+        if (need_aprob) {  // aprob
+            const double* dstr = forest.getLeafDstr(leaf);
+            for (int lab_idx = 0; lab_idx < nlabels_; lab_idx++)
+                aprob[offset + lab_idx] += dstr[lab_idx];
+        }
 
-void RForest::buildOneTreeAsync (int* index)
-/*
- * tree building function: pick a bagging set from bagging_set_ to build one tree a time until no set to fetch
- */
-{
-    bool finished = false;
-    int ind;
+        if (need_waprob) {  // waprob
+            double accuracy = forest.getTreeAccuracy(tree_idx);
+            const double* dstr = forest.getLeafDstr(leaf);
+            for (int lab_idx = 0; lab_idx < nlabels_; lab_idx++)
+                waprob[offset + lab_idx] += dstr[lab_idx] * accuracy;
+        }
+    };
 
-    while (!finished) {
+    if (forest.nbytes() >= PRED_BLOCK_MIN_BYTES) {
+        for (int tree_idx = 0; tree_idx < forest.ntree(); ++tree_idx)
+            for (int i = 0; i < nobs; ++i)
+                addLeaf(tree_idx, i);
+    } else {
+        // The whole forest stays in cache anyway, so each observation goes through all the trees at once,
+        // keeping its values and results in cache instead of the block's.
+        for (int i = 0; i < nobs; ++i)
+            for (int tree_idx = 0; tree_idx < forest.ntree(); ++tree_idx)
+                addLeaf(tree_idx, i);
+    }
+
+    // Calculate predictions.
+    for (int i = 0, offset = 0; i < nobs; ++i, offset += nlabels_) {
+        if (need_class)  // class or response
+            class_iter[begin + i] = distance(vote + offset, max_element(vote + offset, vote + offset + nlabels_)) + 1;
 
-        if (*pInterrupt_)
-            break;
+        if (need_prob) {  // prob
+            for (int lab_idx = 0; lab_idx < nlabels_; lab_idx++)
+                prob[offset + lab_idx] /= ntree_;
+        }
 
-        unique_lock<mutex> ulk(mut_);
-        if (*index < ntree_) {
-            ind = *index;
-            (*index)++;
-            ulk.unlock();
-        } else {
-            finished = true;
+        if (need_aprob) {  // aprob
+            for (int lab_idx = 0; lab_idx < nlabels_; lab_idx++)
+                aprob[offset + lab_idx] /= ntree_;
         }
 
-        if (!finished) {
-            buildOneTree(ind);
+        if (need_waprob) {  // waprob
+            for (int lab_idx = 0; lab_idx < nlabels_; lab_idx++)
+                waprob[offset + lab_idx] /= sumAccuracy;
         }
     }
 }
 
-Rcpp::List RForest::predict (Dataset* data, int type) {
+void RForest::predictBlocks (const CompiledForest* forest, Dataset* data, int type, int* class_iter, double** res_iter, atomic<int>* next_block, volatile bool* pInterrupt)
+/*
+ * Prediction thread: fetch the next block of <PRED_BLOCK_SIZE> observations to predict until no block left.
+ */
+{
+    int nobs = data->nobs();
+    while (!*pInterrupt) {
+        int begin = (*next_block)++ * PRED_BLOCK_SIZE;
+        if (begin >= nobs) break;
+
+        predictBlock(*forest, data, begin, min(begin + PRED_BLOCK_SIZE, nobs), type, class_iter, res_iter);
+    }
+}
+
+Rcpp::List RForest::predict (Dataset* data, int type, int parallel) {
     // 0 - class; 1 - vote; 2 - prob; 3 - aprob; 4 - waprob
     Rcpp::List res(PRED_TYPE_NUM);
-    double* res_iter[PRED_TYPE_NUM];
+    double* res_iter[PRED_TYPE_NUM] = {NULL};
     int* class_iter = NULL;
 
     int nobs = data->nobs();
 
     bool need_class  = type & PRED_TYPE_CLASS;
     bool need_vote   = type & PRED_TYPE_VOTE;
-    bool need_prob   = type & PRED_TYPE_PROB;
-    bool need_aprob  = type & PRED_TYPE_APROB;
-    bool need_waprob = type & PRED_TYPE_WAPROB;
 
     // Allocate memory.
     for (int tindex = 0, left_type = type; tindex < PRED_TYPE_NUM; tindex++, left_type >>= 1) {
@@ -267,65 +444,45 @@ Rcpp::List RForest::predict (Dataset* data, int type) {
             res[tindex] = R_NilValue;
     }
 
-    // Get predictions.
-    for (int obs_idx = 0; obs_idx < nobs; ++obs_idx) {
-
-        if ((obs_idx & 0x3ff) == 0 && check_interrupt()) throw interrupt_exception(PRED_INTERRUPT_MSG);
-
-        double sumAccuracy = 0;
-
-        // Get leaf node information.
-        for (vector<Tree*>::iterator iter = tree_vec_.begin(); iter != tree_vec_.end(); ++iter) {
-            Node* node = (*iter)->predictLeafNode(data, obs_idx);
+    const CompiledForest& forest = compile();
 
-            if (need_vote || need_class) res_iter[PRED_TYPE_VOTE_IDX][node->label()]++;  // vote or class
-
-            if (need_prob) res_iter[PRED_TYPE_PROB_IDX][node->label()]++;  // prob
+    // Get predictions.
+    int nthreads = parallel < 0 ? thread::hardware_concurrency() - 2 : parallel;
+    if (nthreads <= 1 || nobs <= PRED_BLOCK_SIZE) {
 
-            if (need_aprob) {  // aprob
-                vector<double> classDistributions = node->getLabelDstr();
-                for (int lab_idx = 0; lab_idx < nlabels_; lab_idx++)
-                    res_iter[PRED_TYPE_APROB_IDX][lab_idx] += classDistributions[lab_idx];
-            }
+        for (int begin = 0; begin < nobs; begin += PRED_BLOCK_SIZE) {
+            if ((begin & 0x3ff) == 0 && check_interrupt()) throw interrupt_exception(PRED_INTERRUPT_MSG);
 
-            if (need_waprob) {  // waprob
-                vector<double> classDistributions = node->getLabelDstr();
-                double accuracy = 1 - (*iter)->getTreeOOBErrorRate();
-                sumAccuracy += accuracy;
-                for (int lab_idx = 0; lab_idx < nlabels_; lab_idx++)
-                    res_iter[PRED_TYPE_WAPROB_IDX][lab_idx] += classDistributions[lab_idx] * accuracy;
-            }
+            predictBlock(forest, data, begin, min(begin + PRED_BLOCK_SIZE, nobs), type, class_iter, res_iter);
         }
 
-        // Calculate predictions.
-        if (need_class) {  // class or response
-            class_iter[obs_idx] =
-                distance(res_iter[PRED_TYPE_VOTE_IDX],
-                         max_element(res_iter[PRED_TYPE_VOTE_IDX],
-                                     res_iter[PRED_TYPE_VOTE_IDX] + nlabels_))
-                 + 1;
-        }
+    } else {
 
-        if (need_prob) {  // prob
-            for (int lab_idx = 0; lab_idx < nlabels_; lab_idx++)
-                res_iter[PRED_TYPE_PROB_IDX][lab_idx] /= ntree_;
-        }
+        // Threads score disjoint blocks of observations, and main thread is left for interrupt check.
+        volatile bool interrupt = false;
+        atomic<int>   next_block(0);
 
-        if (need_aprob) {  // aprob
-            for (int lab_idx = 0; lab_idx < nlabels_; lab_idx++)
-                res_iter[PRED_TYPE_APROB_IDX][lab_idx] /= ntree_;
-        }
+        vector<future<void> > results(nthreads);
+        for (int i = 0; i < nthreads; i++)
+            results[i] = async(launch::async, &RForest::predictBlocks, this, &forest, data, type, class_iter, res_iter, &next_block, &interrupt);
 
-        if (need_waprob) {  // waprob
-            for (int lab_idx = 0; lab_idx < nlabels_; lab_idx++)
-                res_iter[PRED_TYPE_WAPROB_IDX][lab_idx] /= sumAccuracy;
+        for (int i = 0; i < nthreads; i++) {
+#if (defined(__GNUC__) && ((__GNUC__ == 4 && __GNUC_MINOR__ >= 7) || (__GNUC__ >= 5))) || defined(__clang__)
+            while (results[i].wait_for(chrono::milliseconds {100}) != future_status::ready) {
+#else
+            while (!results[i].wait_for(chrono::milliseconds {100})) {
+#endif
+                // check interruption per 100 milliseconds.
+                if (check_interrupt()) {
+                    interrupt = true;
+                    for (int j = 0; j < nthreads; j++)
+                        results[j].wait();
+                    throw interrupt_exception(PRED_INTERRUPT_MSG);
+                }
+            }
+            results[i].get();
         }
 
-        // Update pointers.
-        for (int tindex = 1, left_type = type >> 1; tindex < PRED_TYPE_NUM; tindex++, left_type >>= 1) {
-            if (left_type % 2 || ( tindex == PRED_TYPE_VOTE_IDX && need_class))
-                res_iter[tindex] += nlabels_;
-        }
     }
 
     // Remove vote because it is used for class.
@@ -499,12 +656,29 @@ void RForest::saveModel (Rcpp::List& wsrf_R)
 
     vector<vector<int> > oob_predict_label_set_vec(ntree_);
     vector<vector<double> > tree_IGR_VIs_vec(ntree_);
+    vector<vector<int> > limit_stops_vec(ntree_);
+    vector<int> ws_growths_vec(ntree_);
     for (int i = 0; i < ntree_; i++) {
         oob_predict_label_set_vec[i].swap(tree_vec_[i]->getOOBPredictLabelSet());
         tree_IGR_VIs_vec[i].swap(tree_vec_[i]->getTreeIGRVIs());
+        limit_stops_vec[i].swap(tree_vec_[i]->getLimitStops());
+        ws_growths_vec[i] = tree_vec_[i]->getWorkspaceGrowths();
     }
     wsrf_R[OOB_PREDICT_LABELS_IDX]  = Rcpp::wrap(oob_predict_label_set_vec);
     wsrf_R[TREE_IGR_IMPORTANCE_IDX] = Rcpp::wrap(tree_IGR_VIs_vec);
+    wsrf_R[TREE_LIMIT_STOPS_IDX]    = Rcpp::wrap(limit_stops_vec);
+    wsrf_R[TREE_WS_GROWTHS_IDX]     = Rcpp::wrap(ws_growths_vec);
+
+    if (!screen_ratio_vec_.empty()) {
+        Rcpp::NumericVector ratio_vec = Rcpp::wrap(screen_ratio_vec_);
+        ratio_vec.attr("names") = Rcpp::wrap(meta_data_->getVarNames());
+
+        vector<string> var_names;
+        for (int vindex : feature_vars_)
+            var_names.push_back(meta_data_->getVarName(vindex));
+
+        wsrf_R[SCREENING_IDX] = Rcpp::List::create(Rcpp::Named("gainRatio") = ratio_vec, Rcpp::Named("vars") = Rcpp::wrap(var_names));
+    }
 }
 
 void RForest::saveMeasures (Rcpp::List& wsrf_R)
@@ -5,8 +5,12 @@
 #include <mutex>
 #include <future>
 #include <chrono>
+#include <atomic>
+#include <numeric>
 
 #include "tree.h"
+#include "compiled_forest.h"
+#include "task_scheduler.h"
 
 using namespace std;
 
@@ -16,9 +20,9 @@ private:
     TargetData* targ_data_;
     MetaData*   meta_data_;
 
-    vector<vector<int> > bagging_set_;  // Bagging set for each tree, generated by each individual tree.
     vector<vector<int> > oob_set_vec_;  // Out-of-Bag set for each tree.
     vector<Tree*>        tree_vec_;     // All trees in the forest.
+    CompiledForest*      compiled_forest_;  // All trees flattened for prediction, NULL until compiled.
 
     int       ntree_;         // Number of trees.
     unsigned* tree_seeds_;     // Seed for each tree.
@@ -27,6 +31,18 @@ private:
     int       mtry_;           // Number of variables selected for node splitting.
     bool      weights_;        // Weight variable or not.
     int       min_node_size_;  // Minimum node size.
+    int       max_depth_;      // Maximum depth of nodes, no limit if 0.
+    int       max_nodes_;      // Maximum number of nodes in each tree, no limit if 0.
+    int       max_leaves_;     // Maximum number of leaf nodes in each tree grown best first, or 0 if grown depth first.
+    double    min_gain_;       // Minimum information gain of a split.
+    int       nrand_splits_;   // Number of random split points tried for a continuous variable (extremely randomized trees), 0 to try all.
+    int       igr_sampsize_;   // Number of observations subsampled to estimate the weights of variables for IGR, 0 to use all.
+    int       screen_nvars_;   // Number of variables kept by the screening, no limit if 0.
+    double    screen_ratio_;   // Minimum information gain ratio of variables kept by the screening, no limit if negative.
+    bool      presort_;        // Whether presort continuous variables once for all trees.
+    int       maxbins_;        // Maximum number of bins for continuous variables, 0 if not binned.
+    vector<int> sampsize_;     // Number of observations drawn for each tree, of size 1, or nlabels if drawn for each class label.
+    bool      replace_;        // Whether draw observations with replacement.
 
     double rf_oob_error_rate_;
     double rf_strength_;
@@ -43,9 +59,11 @@ private:
 
     vector<double> raw_perm_VIs_;    // Vector of size (nlabels+1)*nvars: Raw vairable importance on each class label, before scaled, plus one row for VI over all class labels.
     vector<double> sigma_perm_VIs_;  // Vector of size (nlabels+1)*nvars: Standard deviation of variable impaortance on each class label, , plus one row for VI SD over all class labels.
+    vector<int>    feature_vars_;       // The variables all trees select from, in ascending order.
+    vector<double> screen_ratio_vec_;   // Vector of size nvars: Information gain ratio of each variable on the training set, empty if not screened.
+
     vector<double> IGR_VIs_;         // Vector of size nvars: The information gain ratio decreases for each variable.
 
-    mutex mut_;
 
     volatile bool* pInterrupt_;  // Interruption or exception flag.
     bool isParallel_;  // Run in parallel or not.
@@ -57,13 +75,19 @@ private:
     void calcRFCorrelationAndCS2 ();
     void assessPermVariableImportance ();
 
+    void predictBlock (const CompiledForest& forest, Dataset* data, int begin, int end, int type, int* class_iter, double** res_iter);
+    void predictBlocks (const CompiledForest* forest, Dataset* data, int type, int* class_iter, double** res_iter, atomic<int>* next_block, volatile bool* pInterrupt);
+
 public:
 
-    RForest (Rcpp::List& model_list, MetaData* meta_data, TargetData* targdata);
-    RForest (Dataset*, TargetData*, MetaData*, int, int, int, bool, bool, SEXP, volatile bool*);
+    RForest (Rcpp::List& model_list, MetaData* meta_data, TargetData* targdata, bool predict_only = false);
+    RForest (Dataset*, TargetData*, MetaData*, int, int, int, int, int, int, double, int, int, int, double, bool, bool, bool, bool, int, const vector<int>&, bool, SEXP, volatile bool*);
     ~RForest ();
 
-    Rcpp::List predict (Dataset* data, int type);
+    const CompiledForest& compile ();
+
+    // parallel: 0 or 1 (sequential);  < 0 (cores-2 threads); > 1 (the exact num of threads)
+    Rcpp::List predict (Dataset* data, int type, int parallel);
 
     void saveModel (Rcpp::List& wsrf_R);
     void saveMeasures (Rcpp::List& wsrf_R);
@@ -88,12 +112,12 @@ public:
         if (importance_) assessPermVariableImportance();
     }
 
-    void buildOneTree (int ind);
+    void screenVars (Workspace* workspace, TaskScheduler* scheduler = NULL, vector<Workspace>* thread_workspaces = NULL);
+    void buildOneTree (int ind, Workspace* workspace, TaskScheduler* scheduler = NULL, vector<Workspace>* thread_workspaces = NULL);
     void buidForestSeq ();
 
     // parallel: 0 or 1 (sequential);  < 0 (cores-2 threads); > 1 (the exact num of threads)
     void buildForestAsync (int parallel);
-    void buildOneTreeAsync (int* index);
 
 };
 
@@ -6,16 +6,32 @@ Sampling::Sampling(unsigned seed, volatile bool* pInterrupt, bool isParallel) {
     isParallel_ = isParallel;
 }
 
-vector<int> Sampling::nonReplaceRandomSample(vector<int> var_vec, int nselect)
+vector<int> Sampling::nonReplaceRandomSample(const vector<int>& var_vec, int nselect)
 /*
  * Randomly sample <nselect> numbers from <var_vec> without replacement.
  * If <nselect> greater than the size of <var_vec>, return <var_vec> itself.
  */
+{
+    vector<int> result;
+    vector<int> pool;
+    nonReplaceRandomSample(var_vec, nselect, result, pool);
+    return result;
+}
+
+void Sampling::nonReplaceRandomSample(const vector<int>& var_vec, int nselect, vector<int>& result, vector<int>& pool)
+/*
+ * The same as above, but write the sample into <result> and use <pool> as scratch,
+ * so that no memory is allocated once they are large enough.
+ */
 {
     int nleft = var_vec.size();
-    if (nselect >= nleft) return var_vec;
+    if (nselect >= nleft) {
+        result.assign(var_vec.begin(), var_vec.end());
+        return;
+    }
 
-    vector<int> result(nselect);
+    result.resize(nselect);
+    pool.assign(var_vec.begin(), var_vec.end());
 
     default_random_engine re {seed_};
     for (int i = 0; i < nselect; ++i) {
@@ -23,13 +39,11 @@ vector<int> Sampling::nonReplaceRandomSample(vector<int> var_vec, int nselect)
         uniform_int_distribution<int> uid {0, nleft - 1};
         int random_num = uid(re);
 
-        result[i] = var_vec[random_num];
-        var_vec[random_num] = var_vec[nleft - 1];
+        result[i] = pool[random_num];
+        pool[random_num] = pool[nleft - 1];
         nleft--;
 
     }
-
-    return result;
 }
 
 vector<int> Sampling::nonReplaceWeightedSample(const vector<double>& originalweights, int nselect, bool needsqrt)
@@ -37,13 +51,24 @@ vector<int> Sampling::nonReplaceWeightedSample(const vector<double>& originalwei
  * Weighted randomly sample without replacement.
  * Return the indexes of items in <originalweights> being selected.
  */
+{
+    vector<int> result;
+    nonReplaceWeightedSample(originalweights, nselect, result, weights_, wst_, needsqrt);
+    return result;
+}
+
+void Sampling::nonReplaceWeightedSample(const vector<double>& originalweights, int nselect, vector<int>& result, vector<double>& weights, vector<int>& wst, bool needsqrt)
+/*
+ * The same as above, but write the indexes into <result> and use <weights> and <wst> as scratch,
+ * so that no memory is allocated once they are large enough.
+ */
 {
     int n    = originalweights.size();
     nselect  = nselect >= n ? n : nselect;
-    weights_ = vector<double>(n+1);
-    wst_     = vector<int>(n+1);
+    weights.assign(n+1, 0);
+    wst.assign(n+1, 0);
 
-    vector<int> result(nselect);
+    result.resize(nselect);
 
     /*
      * If the number of selection is greater than the size of the vector, then return all.
@@ -51,7 +76,7 @@ vector<int> Sampling::nonReplaceWeightedSample(const vector<double>& originalwei
     if (nselect >= n) {
         for (int i = 0; i < n; i++)
             result[i] = i;
-        return result;
+        return;
     }
 
     /*
@@ -64,61 +89,60 @@ vector<int> Sampling::nonReplaceWeightedSample(const vector<double>& originalwei
             // If run sequentially, check user interruption directly.
             throw interrupt_exception(MODEL_INTERRUPT_MSG);
         } else if (*pInterrupt_) {
-            return vector<int>();
+            result.clear();
+            return;
         }
 
-        weights_[j] = needsqrt ? sqrt(originalweights[i]) : originalweights[i];
-        sum += weights_[j];
+        weights[j] = needsqrt ? sqrt(originalweights[i]) : originalweights[i];
+        sum += weights[j];
     }
 
     if (sum != 0) {
         for (int i = 1; i <= n; i++) {
-            weights_[i] /= sum;
-            int temp = weights_[i] * RAND_MAX;
-            weights_[i] = temp;
+            weights[i] /= sum;
+            int temp = weights[i] * RAND_MAX;
+            weights[i] = temp;
         }
     } else {
         int temp = RAND_MAX / (double) n;
         for (int i = 1; i <= n; i++) {
-            weights_[i] = temp;
+            weights[i] = temp;
         }
     }
 
     /*
      * Weighted sampling.
      */
-    copy(weights_.begin(), weights_.end(), wst_.begin());
-    for (int i = n; i > 1; i--) wst_[i>>1] += wst_[i];
+    copy(weights.begin(), weights.end(), wst.begin());
+    for (int i = n; i > 1; i--) wst[i>>1] += wst[i];
 
     default_random_engine re {seed_};
 
     for(int i = 0; i < nselect; ++ i) {
-        uniform_int_distribution<int> uid {0, wst_[1]-1};
+        uniform_int_distribution<int> uid {0, wst[1]-1};
         int rand_num = uid(re);
         int j = 1;
-        while (rand_num > weights_[j]) {
-            rand_num -= weights_[j];
+        while (rand_num > weights[j]) {
+            rand_num -= weights[j];
             j <<= 1;
-            if (rand_num > wst_[j]) {
-                rand_num -= wst_[j];
+            if (rand_num > wst[j]) {
+                rand_num -= wst[j];
                 j++;
             }
         }
 
         result[i] = j-1;
 
-        int w = weights_[j];
-        weights_[j] = 0;
+        int w = weights[j];
+        weights[j] = 0;
 
         while (j != 0) {
-            wst_[j] -= w;
+            wst[j] -= w;
             j >>= 1;
         }
     //    //may be the largest right is smaller RAND_MAX,because double to int may lose information
     //    return n - 1;
     }
-
-    return result;
 }
 
 vector<int> Sampling::nonReplaceWeightedSample(const vector<int>& var_vec, const vector<double>& originalweights, int nselect, bool needsqrt) {
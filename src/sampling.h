@@ -15,8 +15,10 @@ private:
 
 public:
     Sampling(unsigned seed, volatile bool* pInterrupt, bool isParallel);
-    vector<int> nonReplaceRandomSample(vector<int> var_vec, int nselect);
+    vector<int> nonReplaceRandomSample(const vector<int>& var_vec, int nselect);
+    void        nonReplaceRandomSample(const vector<int>& var_vec, int nselect, vector<int>& result, vector<int>& pool);
     vector<int> nonReplaceWeightedSample(const vector<double>& originalweights, int nselect, bool needsqrt=true);
+    void        nonReplaceWeightedSample(const vector<double>& originalweights, int nselect, vector<int>& result, vector<double>& weights, vector<int>& wst, bool needsqrt=true);
     vector<int> nonReplaceWeightedSample(const vector<int>& var_vec, const vector<double>& originalweights, int nselect, bool needsqrt=true);
 };
 
@@ -0,0 +1,206 @@
+#include "task_scheduler.h"
+
+thread_local TaskScheduler* TaskScheduler::current_scheduler_ = NULL;
+thread_local int            TaskScheduler::current_index_     = -1;
+
+TaskScheduler::TaskScheduler (int nthreads, volatile bool* pInterrupt) {
+    nqueued_    = 0;
+    npending_   = 0;
+    next_queue_ = 0;
+    stop_       = false;
+    pInterrupt_ = pInterrupt;
+
+    if (nthreads < 1) nthreads = 1;
+    queue_vec_ = vector<TaskQueue*>(nthreads);
+    for (int i = 0; i < nthreads; i++)
+        queue_vec_[i] = new TaskQueue();
+
+    for (int i = 0; i < nthreads; i++)
+        thread_vec_.push_back(thread(&TaskScheduler::run, this, i));
+}
+
+TaskScheduler::~TaskScheduler () {
+    {
+        lock_guard<mutex> lk(mut_);
+        stop_ = true;
+    }
+    work_cv_.notify_all();
+
+    for (thread& t : thread_vec_)
+        t.join();
+    for (TaskQueue* queue : queue_vec_)
+        delete queue;
+}
+
+void TaskScheduler::submit (Task task)
+/*
+ * Queue <task>, to the deque of the current thread if called from a task of this pool.
+ */
+{
+    int nthreads = queue_vec_.size();
+    int qindex;
+    {
+        lock_guard<mutex> lk(mut_);
+        npending_++;
+        if (current_scheduler_ == this) {
+            qindex = current_index_;
+        } else {
+            qindex = next_queue_;
+            next_queue_ = (next_queue_ + 1) % nthreads;
+        }
+    }
+
+    {
+        lock_guard<mutex> lk(queue_vec_[qindex]->mut_);
+        queue_vec_[qindex]->tasks_.push_back(std::move(task));
+    }
+
+    {
+        lock_guard<mutex> lk(mut_);
+        nqueued_++;
+    }
+    work_cv_.notify_one();
+}
+
+void TaskScheduler::wait ()
+/*
+ * Block until all the tasks submitted are finished, and rethrow the first exception thrown by them.
+ *
+ * Must not be called from a task of this pool.
+ */
+{
+    unique_lock<mutex> lk(mut_);
+    done_cv_.wait(lk, [this] { return npending_ == 0; });
+
+    if (error_) {
+        exception_ptr error = error_;
+        error_ = nullptr;
+        rethrow_exception(error);
+    }
+}
+
+bool TaskScheduler::takeTask (int index, Task& task)
+/*
+ * Take the newest task of thread <index>, or else steal the oldest task of another thread.
+ */
+{
+    int nthreads = queue_vec_.size();
+    for (int i = 0; i < nthreads; i++) {
+        TaskQueue* queue = queue_vec_[(index + i) % nthreads];
+        lock_guard<mutex> lk(queue->mut_);
+        if (queue->tasks_.empty()) continue;
+
+        if (i == 0) {
+            task = std::move(queue->tasks_.back());
+            queue->tasks_.pop_back();
+        } else {
+            task = std::move(queue->tasks_.front());
+            queue->tasks_.pop_front();
+        }
+        return true;
+    }
+    return false;
+}
+
+void TaskScheduler::finishTask (exception_ptr error) {
+    lock_guard<mutex> lk(mut_);
+    if (error && !error_) error_ = error;
+    if (--npending_ == 0) done_cv_.notify_all();
+}
+
+void TaskScheduler::run (int index)
+/*
+ * Thread body: run tasks until the pool stops, sleeping while there is no task.
+ */
+{
+    current_scheduler_ = this;
+    current_index_     = index;
+
+    while (true) {
+        {
+            unique_lock<mutex> lk(mut_);
+            work_cv_.wait(lk, [this] { return stop_ || nqueued_ > 0; });
+            if (stop_) return;
+            nqueued_--;  // Reserve one of the queued tasks.
+        }
+
+        // A task is left for each reservation, though another thread may take
+        // the one found first, so scan again until one is taken.
+        Task task;
+        while (!takeTask(index, task));
+
+        exception_ptr error = nullptr;
+        if (!*pInterrupt_) {
+            try {
+                task(index);
+            } catch (...) {
+                error = current_exception();
+                *pInterrupt_ = true;  // Inform other tasks of no need to continue.
+            }
+        }
+        finishTask(error);
+    }
+}
+
+void TaskScheduler::runParallel (int ncopies, const ParallelWork& work)
+/*
+ * Run <work> on the current thread as copy 0, and offer copies 1 to <ncopies>-1 to idle threads.
+ * Return when all the copies started have finished, rethrowing the first exception from them.
+ *
+ * Copies not started by the time copy 0 finishes are skipped, so <work> must share its items
+ * among the copies dynamically, and the current thread never waits for a busy pool.
+ *
+ * A copy started on a pool thread is the only task running there until it finishes, so it may use
+ * the scratch memory of that thread.
+ */
+{
+    struct Shared {
+        mutex              mut_;
+        condition_variable done_cv_;
+        int                nrunning_;  // Number of copies running on other threads.
+        bool               closed_;    // No more copies may start.
+        exception_ptr      error_;
+    };
+
+    shared_ptr<Shared> shared = make_shared<Shared>();
+    shared->nrunning_ = 0;
+    shared->closed_   = false;
+
+    // The helper tasks may outlive this call, when they are taken after copy 0 finished,
+    // so they keep <shared> alive but use <work> only if started in time.
+    const ParallelWork* pwork = &work;
+    for (int copy = 1; copy < ncopies; copy++) {
+        submit([shared, pwork, copy] (int index) {
+            {
+                lock_guard<mutex> lk(shared->mut_);
+                if (shared->closed_) return;
+                shared->nrunning_++;
+            }
+
+            exception_ptr error = nullptr;
+            try {
+                (*pwork)(copy, index);
+            } catch (...) {
+                error = current_exception();
+            }
+
+            lock_guard<mutex> lk(shared->mut_);
+            if (error && !shared->error_) shared->error_ = error;
+            if (--shared->nrunning_ == 0) shared->done_cv_.notify_all();
+        });
+    }
+
+    exception_ptr error = nullptr;
+    try {
+        work(0, current_scheduler_ == this ? current_index_ : -1);
+    } catch (...) {
+        error = current_exception();
+    }
+
+    unique_lock<mutex> lk(shared->mut_);
+    shared->closed_ = true;
+    shared->done_cv_.wait(lk, [&shared] { return shared->nrunning_ == 0; });
+
+    if (!error) error = shared->error_;
+    if (error) rethrow_exception(error);
+}
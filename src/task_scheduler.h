@@ -0,0 +1,77 @@
+#ifndef TASK_SCHEDULER_H_
+#define TASK_SCHEDULER_H_
+
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <exception>
+#include <deque>
+#include <memory>
+#include <vector>
+
+using namespace std;
+
+class TaskScheduler
+/*
+ * A pool of threads running tasks by work stealing.
+ *
+ * Each thread owns a deque of tasks.  It takes tasks from the back of its own deque, and when that is empty,
+ * steals from the front of the others', where the oldest and usually largest tasks are.  A task may submit
+ * more tasks, which go to the deque of the thread running it.
+ *
+ * Idle threads and wait() sleep on condition variables instead of polling.
+ *
+ * A task may also share its own work with idle threads by runParallel().
+ */
+{
+public:
+    typedef function<void (int)> Task;  // Called with the index of the thread running it, in [0, nthreads).
+    typedef function<void (int, int)> ParallelWork;  // Called with the copy number, and the index of the thread running it, -1 if outside the pool.
+
+private:
+    struct TaskQueue {
+        mutex        mut_;
+        deque<Task>  tasks_;
+    };
+
+    vector<TaskQueue*> queue_vec_;   // Task deque of each thread.
+    vector<thread>     thread_vec_;
+
+    mutex              mut_;         // Guards the counters and flags below.
+    condition_variable work_cv_;     // Signalled when a task is queued or the pool stops.
+    condition_variable done_cv_;     // Signalled when no task is pending.
+    int                nqueued_;     // Number of tasks in the deques.
+    int                npending_;    // Number of tasks submitted but not finished.
+    int                next_queue_;  // Deque for the next task submitted from outside the pool.
+    bool               stop_;
+    exception_ptr      error_;       // The first exception thrown by a task.
+
+    volatile bool*     pInterrupt_;  // Tasks are dropped without running once it is set.
+
+    static thread_local TaskScheduler* current_scheduler_;  // The pool the current thread belongs to.
+    static thread_local int            current_index_;      // The index of the current thread in its pool.
+
+    bool takeTask (int index, Task& task);
+    void finishTask (exception_ptr error);
+    void run (int index);
+
+    TaskScheduler (const TaskScheduler&);
+    TaskScheduler& operator= (const TaskScheduler&);
+
+public:
+
+    TaskScheduler (int nthreads, volatile bool* pInterrupt);
+    ~TaskScheduler ();
+
+    int nthreads () const {
+        return thread_vec_.size();
+    }
+
+    void submit (Task task);
+    void wait ();
+    void runParallel (int ncopies, const ParallelWork& work);
+
+};
+
+#endif
@@ -4,12 +4,24 @@ Tree::Tree (Dataset* train_set,
         TargetData* targdata,
         MetaData* meta_data,
         int min_node_size,
+        int max_depth,
+        int max_nodes,
+        int max_leaves,
+        double min_gain,
+        int nrand_splits,
+        int igr_sampsize,
         unsigned seed,
-        vector<int>* pbagging_vec,
         vector<int>* poob_vec,
+        const vector<int>* psampsize,
+        bool isreplace,
         int mtry,
+        const vector<int>* pfeature_vars,
         bool isweight,
         bool isimportance,
+        bool ispresort,
+        Workspace* workspace,
+        TaskScheduler* scheduler,
+        vector<Workspace>* thread_workspaces,
         volatile bool* pInterrupt,
         bool isParallel) {
 
@@ -17,18 +29,34 @@ Tree::Tree (Dataset* train_set,
     targ_data_     = targdata;
     meta_data_     = meta_data;
     min_node_size_ = min_node_size;
+    max_depth_     = max_depth;
+    max_nodes_     = max_nodes;
+    max_leaves_    = max_leaves;
+    min_gain_      = min_gain;
+    nrand_splits_  = nrand_splits;
+    igr_sampsize_  = igr_sampsize;
+    nreserved_     = 0;
     seed_          = seed;
-    pbagging_vec_  = pbagging_vec;
     poob_vec_      = poob_vec;
     nnodes_        = 0;
     node_id_       = 0;
     root_          = NULL;
     mtry_          = mtry;
+    pfeature_vars_ = pfeature_vars;
+    psampsize_     = psampsize;
+    isreplace_     = isreplace;
     isweight_      = isweight;
     isimportance_  = isimportance;
+    ispresort_     = ispresort;
+    isbinned_      = train_set->isBinned();
+    workspace_     = workspace;
+    scheduler_     = scheduler;
+    thread_workspaces_ = thread_workspaces;
 
     tree_oob_error_rate_  = NA_REAL;
     label_oob_error_rate_ = vector<double>(meta_data->nlabels(), 0);
+    limit_stop_vec_       = vector<int>(LIMIT_NUM, 0);
+    ws_growths_           = 0;
     tree_IGR_VIs_         = vector<double>(meta_data->nvars(), 0);
 
     pInterrupt_ = pInterrupt;
@@ -49,8 +77,12 @@ Tree::Tree (const vector<vector<double> >& node_infos, MetaData* meta_data, doub
     meta_data_    = meta_data;
     node_id_      = 0;
     poob_vec_     = NULL;
-    pbagging_vec_ = NULL;
     seed_         = NA_INTEGER;
+    ispresort_    = false;
+    workspace_    = NULL;
+    scheduler_    = NULL;
+    thread_workspaces_ = NULL;
+    isbinned_     = false;
 
     pInterrupt_ = NULL;
     isParallel_ = false;
@@ -61,7 +93,7 @@ Tree::Tree (const vector<vector<double> >& node_infos, MetaData* meta_data, doub
     nnodes_ = node_infos.size();
 
     for (int i = nnodes_ - 1; i >= 0; i--) {
-        Node* node = new Node(node_infos[i], meta_data_);
+        Node* node = arena_.create<Node>(arena_, node_infos[i], meta_data_);
         noparent_nodes.push(node);
 
         for (int j = node->nchild() - 1; j >= 0; j--) {
@@ -77,41 +109,92 @@ Tree::Tree (const vector<vector<double> >& node_infos, MetaData* meta_data, doub
 
 void Tree::genBaggingSets ()
 /*
- * Sample the observations with replacement.
+ * Sample observations with or without replacement, from all the observations,
+ * or from each class label separately (stratified) if <psampsize_> has a size for each.
  * Generate bagging data set and out-of-bag data set.
+ *
+ * The bagging set is kept as the number of times each observation is drawn in <obs_count_>,
+ * and the distinct observations drawn in <obs_buf_>, only while the tree is growing.
+ * Both are determined by the seed of the tree, as well as the out-of-bag set.
  */
 {
 
     //TODO: If possible, make similar RNG codes into a single function.
 
     int nobs = train_set_->nobs();
-    vector<bool> selected_status(nobs, false);
+    obs_count_ = vector<int>(nobs, 0);
 
-    uniform_int_distribution<int> uid {0, nobs - 1};
     default_random_engine re {seed_};
 
-    for (int j = 0; j < nobs; ++j) {
-        int random_num = uid(re);
-
-        (*pbagging_vec_)[j] = random_num;
-        selected_status[random_num] = true;
+    const vector<int>& sampsize = *psampsize_;
+    if (sampsize.size() == 1) {
+        drawObs(re, NULL, nobs, sampsize[0]);
+    } else {
+        for (int label = 0; label < (int) sampsize.size(); label++) {
+            const vector<int>& label_obs = targ_data_->getLabelObs(label);
+            drawObs(re, label_obs.data(), label_obs.size(), sampsize[label]);
+        }
     }
 
     vector<int> oob;
-    for (int ind = 0; ind < nobs; ind++)
-        if (!selected_status[ind]) oob.push_back(ind);
+    obs_buf_.clear();
+    for (int ind = 0; ind < nobs; ind++) {
+        if (obs_count_[ind] > 0) obs_buf_.push_back(ind);
+        else oob.push_back(ind);
+    }
     poob_vec_->swap(oob);
 
     oob_predict_label_set_ = vector<int>(poob_vec_->size());
 }
 
+void Tree::drawObs (default_random_engine& re, const int* obs_array, int n, int ndraw)
+/*
+ * Draw <ndraw> observations into <obs_count_> from the <n> observations in <obs_array>,
+ * or from observations 0 to <n>-1 if <obs_array> is NULL.
+ */
+{
+    if (n == 0) return;
+
+    if (isreplace_) {
+        uniform_int_distribution<int> uid {0, n - 1};
+        for (int j = 0; j < ndraw; ++j) {
+            int k = uid(re);
+            obs_count_[obs_array ? obs_array[k] : k]++;
+        }
+    } else {
+        // Partial Fisher-Yates shuffle: The first <ndraw> positions of <pool> end up a random subset.
+        vector<int> pool(n);
+        for (int j = 0; j < n; ++j)
+            pool[j] = obs_array ? obs_array[j] : j;
+
+        ndraw = min(ndraw, n);
+        for (int j = 0; j < ndraw; ++j) {
+            uniform_int_distribution<int> uid {j, n - 1};
+            swap(pool[j], pool[uid(re)]);
+            obs_count_[pool[j]] = 1;
+        }
+    }
+}
+
 void Tree::build ()
 /*
  * Grow a tree.
  */
 {
     genBaggingSets();
-    root_ = genC4p5Tree(*pbagging_vec_, meta_data_->getFeatureVars());
+
+    vector<vector<int> > sorted_obs_vecs;
+    if (ispresort_) genSortedObsVecs(sorted_obs_vecs);
+
+    child_mark_ = vector<int>(train_set_->nobs());
+
+    int ngrowths = workspace_->ngrowths();
+    root_ = genC4p5Tree(sorted_obs_vecs);
+    ws_growths_ = workspace_->ngrowths() - ngrowths;
+
+    vector<int>().swap(obs_buf_);
+    vector<int>().swap(obs_count_);
+    vector<int>().swap(child_mark_);
 
     if (!isParallel_ && check_interrupt()) {
         // If run sequentially, check user interruption directly.
@@ -121,72 +204,500 @@ void Tree::build ()
         return;
     }
 
+    doSthOnNodes(root_, &Tree::addOneIGRVI);
+
     calcOOBMeasures(isimportance_);
 }
 
-Node* Tree::genC4p5Tree (const vector<int>& obs_vec, const vector<int>& var_vec)
+void Tree::genSortedObsVecs (vector<vector<int> >& sorted_obs_vecs)
 /*
- * Build a tree recursively.
+ * Filter the presorted orders of the training set down to the observations in the bagging set,
+ * for each continuous variable the tree may split by.
  */
 {
+    int nobs = train_set_->nobs();
+    int nvars = meta_data_->nvars();
+    sorted_obs_vecs = vector<vector<int> >(nvars);
+
+    for (int vindex : *pfeature_vars_) {
+        if (meta_data_->getVarType(vindex) == DISCRETE) continue;
+
+        const vector<int>& sorted_idx_vec = train_set_->getSortedIndex(vindex);
+        vector<int>& sorted_obs_vec = sorted_obs_vecs[vindex];
+        sorted_obs_vec.reserve(obs_buf_.size());
+        for (int i = 0; i < nobs; i++) {
+            int obs = sorted_idx_vec[i];
+            if (obs_count_[obs] > 0) sorted_obs_vec.push_back(obs);
+        }
+    }
+}
+
+void Tree::partitionObs (int begin, int end, const VarSelectRes& res, vector<int>& child_begin, vector<int>& child_nobs, Workspace* ws)
+/*
+ * Partition the observations [begin, end) of a node in <obs_buf_> in place by the selected variable,
+ * so that each child node owns the range [child_begin[i], child_begin[i+1]), of <child_nobs[i]> copies.
+ *
+ * The partition is stable, and <child_mark_> keeps the child node each observation goes to.
+ */
+{
+    ObsRange obs_vec(obs_buf_.data() + begin, obs_buf_.data() + end, obs_count_.data());
+    int nchild = train_set_->markChildren(obs_vec, res.var_idx_, res.split_value_, child_mark_);
+
+    child_begin.assign(nchild + 1, 0);
+    child_nobs.assign(nchild, 0);
+    for (int obs : obs_vec) {
+        child_begin[child_mark_[obs] + 1]++;
+        child_nobs[child_mark_[obs]] += obs_count_[obs];
+    }
+
+    child_begin[0] = begin;
+    for (int i = 1; i <= nchild; i++)
+        child_begin[i] += child_begin[i - 1];
+
+    vector<int>& next_vec = ws->scatter_vec_;
+    next_vec.assign(child_begin.begin(), child_begin.end() - 1);
+
+    vector<int>& tmp_vec = ws->sorted_obs_vec_;
+    tmp_vec.assign(obs_vec.begin(), obs_vec.end());
+    for (int obs : tmp_vec)
+        obs_buf_[next_vec[child_mark_[obs]]++] = obs;
+}
+
+void Tree::splitSortedObsVecs (vector<vector<int> >& sorted_obs_vecs, const vector<int>& child_begin, vector<vector<vector<int> > >& child_sorted_vecs)
+/*
+ * Distribute the sorted orders of a node to its children by a stable partition,
+ * so that the children need not sort again.  The orders of the node are released.
+ */
+{
+    int nvars  = sorted_obs_vecs.size();
+    int nchild = child_sorted_vecs.size();
+    for (int i = 0; i < nchild; i++)
+        child_sorted_vecs[i] = vector<vector<int> >(nvars);
+
+    for (int vindex = 0; vindex < nvars; vindex++) {
+        vector<int>& sorted_obs_vec = sorted_obs_vecs[vindex];
+        if (sorted_obs_vec.empty()) continue;
+
+        for (int i = 0; i < nchild; i++)
+            child_sorted_vecs[i][vindex].reserve(child_begin[i + 1] - child_begin[i]);
+
+        for (int obs : sorted_obs_vec)
+            child_sorted_vecs[child_mark_[obs]][vindex].push_back(obs);
+
+        vector<int>().swap(sorted_obs_vec);
+    }
+}
+
+void Tree::releaseChildren (GrowFrame& frame)
+/*
+ * Release the sorted orders and histograms left in <frame> once its children are grown,
+ * keeping the frame itself for the next node at its depth.
+ */
+{
+    for (vector<vector<int> >& sorted_obs_vecs : frame.child_sorted_vecs_)
+        vector<vector<int> >().swap(sorted_obs_vecs);
+    for (map<int, vector<int> >& hist_map : frame.child_hist_maps_)
+        hist_map.clear();
+}
+
+void Tree::deriveHistograms (const map<int, vector<int> >& hist_map, const vector<int>& child_begin, vector<map<int, vector<int> > >& child_hist_maps, int child)
+/*
+ * Histogram subtraction: the histograms of the last grown child <child> are the node's minus the siblings',
+ * for the variables whose histograms are known to all the non-empty siblings.
+ */
+{
+    int nchild = child_hist_maps.size();
+    map<int, vector<int> >& child_hist_map = child_hist_maps[child];
+
+    for (map<int, vector<int> >::const_iterator iter = hist_map.begin(); iter != hist_map.end(); ++iter) {
+        int  vindex = iter->first;
+        bool known  = true;
+        for (int i = 0; i < nchild && known; i++)
+            if (i != child && child_begin[i + 1] != child_begin[i] && child_hist_maps[i].count(vindex) == 0)
+                known = false;
+
+        if (!known) continue;
+
+        vector<int> hist = iter->second;
+        int n = hist.size();
+        for (int i = 0; i < nchild; i++) {
+            if (i == child || child_begin[i + 1] == child_begin[i]) continue;
+
+            const vector<int>& sibling_hist = child_hist_maps[i][vindex];
+            for (int j = 0; j < n; j++)
+                hist[j] -= sibling_hist[j];
+        }
+        child_hist_map[vindex].swap(hist);
+    }
+}
+
+Node* Tree::genC4p5Tree (vector<vector<int> >& sorted_obs_vecs)
+/*
+ * Build a tree on the observations in <obs_buf_>, and return the root node.
+ *
+ * The tree is grown depth first, see growSubtree(), or best first if the number of leaf nodes is limited,
+ * see genBestFirstTree().  The root node is seeded by the seed of the tree.
+ *
+ * <sorted_obs_vecs> holds the observations sorted by each continuous variable if presorted, otherwise it is empty.
+ */
+{
+    nreserved_ = 1;
+    if (max_leaves_ > 0) return genBestFirstTree(sorted_obs_vecs);
+
+    map<int, vector<int> > hist_map;
+    return growSubtree(0, obs_buf_.size(), 0, seed_, *pfeature_vars_, sorted_obs_vecs, isbinned_ ? &hist_map : NULL, workspace_);
+}
+
+Node* Tree::growSubtree (int begin, int end, int depth, unsigned seed, const vector<int>& var_vec, vector<vector<int> >& sorted_obs_vecs, map<int, vector<int> >* hist_map, Workspace* ws)
+/*
+ * Grow the subtree of a node at <depth> seeded <seed> on the observations [begin, end) in <obs_buf_>,
+ * with scratch memory <ws>, and return its root.
+ *
+ * Nodes are grown depth first as by recursion, but with an explicit stack of the internal nodes
+ * whose children are being grown, so that deep trees need no deep call stack.
+ * The children of a node with large ones may be grown concurrently instead, see growChildrenParallel().
+ */
+{
+    Node* root = growNode(begin, end, depth, seed, var_vec, sorted_obs_vecs, hist_map, ws);
+    int top = root && root->type() == INTERNALNODE ? depth : depth - 1;  // Depth of the frame on top of the stack in <ws>.
+
+    while (top >= depth) {
+        GrowFrame& frame = ws->getFrame(top);
+        const vector<int>& child_begin = frame.child_begin_;
+        int nchild = frame.child_order_.size();
+        if (frame.next_ == 0 && isWorthSharing(frame)) {
+            growChildrenParallel(frame, ws);
+            releaseChildren(frame);
+            top--;
+            continue;
+        }
+        if (frame.next_ == nchild) {
+            releaseChildren(frame);
+            top--;
+            continue;
+        }
+
+        int k = frame.next_++;
+        int child = frame.child_order_[k];
+        if (child_begin[child + 1] == child_begin[child]) {
+            // Use parent node statistics
+            ObsRange obs_vec(obs_buf_.data() + child_begin.front(), obs_buf_.data() + child_begin.back(), obs_count_.data());
+            frame.node_->setChild(child, createLeafNode(obs_vec, 0, false, ws));
+            continue;
+        }
+
+        if (isbinned_ && k == nchild - 1) {
+            // The siblings are grown, so their histograms are released after use.
+            deriveHistograms(*frame.hist_map_, child_begin, frame.child_hist_maps_, child);
+            for (int i = 0; i < nchild; i++)
+                if (i != child) map<int, vector<int> >().swap(frame.child_hist_maps_[i]);
+        }
+
+        Node* node = growNode(child_begin[child], child_begin[child + 1], top + 1, childSeed(frame.seed_, child), *frame.var_vec_,
+                frame.child_sorted_vecs_[child], isbinned_ ? &frame.child_hist_maps_[child] : NULL, ws);
+        frame.node_->setChild(child, node);
+        if (node && node->type() == INTERNALNODE) top++;
+    }
+
+    return root;
+}
+
+bool Tree::isWorthSharing (const GrowFrame& frame)
+/*
+ * Whether the children of <frame> are grown concurrently: Only if at least two of them are large, so that
+ * sharing pays off and nested sharing stays shallow, and only if the children do not depend on each other,
+ * as they do by the histograms of the last child derived from the siblings', or by the budget of nodes.
+ */
+{
+    if (scheduler_ == NULL || isbinned_ || max_nodes_ > 0) return false;
+
+    const vector<int>& child_begin = frame.child_begin_;
+    int nchild = child_begin.size() - 1;
+    int nlarge = 0;
+    for (int i = 0; i < nchild; i++)
+        if (child_begin[i + 1] - child_begin[i] >= PAR_NODE_MIN_OBS) nlarge++;
+
+    return nlarge > 1;
+}
+
+void Tree::growChildrenParallel (GrowFrame& frame, Workspace* ws)
+/*
+ * Grow the subtrees of the children of <frame>, shared with idle threads of <scheduler_>,
+ * each growing whole subtrees with the scratch memory it keeps in <thread_workspaces_>.
+ *
+ * The subtrees own disjoint ranges of <obs_buf_>, and the seeds of their nodes depend only on their positions,
+ * so the tree is the same as grown sequentially.
+ */
+{
+    const vector<int>& child_begin = frame.child_begin_;
+    int nchild = frame.child_order_.size();
+
+    atomic<int> next_child(0);
+    scheduler_->runParallel(min(nchild, scheduler_->nthreads()), [this, &frame, &child_begin, &next_child, nchild, ws] (int copy, int index) {
+        Workspace* cws = copy == 0 ? ws : &(*thread_workspaces_)[index];
+
+        for (int k = next_child++; k < nchild && !*pInterrupt_; k = next_child++) {
+            int child = frame.child_order_[k];
+            Node* node;
+            if (child_begin[child + 1] == child_begin[child]) {
+                // Use parent node statistics
+                ObsRange obs_vec(obs_buf_.data() + child_begin.front(), obs_buf_.data() + child_begin.back(), obs_count_.data());
+                node = createLeafNode(obs_vec, 0, false, cws);
+            } else {
+                node = growSubtree(child_begin[child], child_begin[child + 1], frame.depth_ + 1, childSeed(frame.seed_, child), *frame.var_vec_,
+                        frame.child_sorted_vecs_[child], NULL, cws);
+            }
+            frame.node_->setChild(child, node);
+        }
+    });
+}
+
+Node* Tree::genBestFirstTree (vector<vector<int> >& sorted_obs_vecs)
+/*
+ * Build a tree best first: The split of each node is selected as soon as the node is reached,
+ * but made only when it is the best of all the open nodes, until the number of leaf nodes reaches <max_leaves_>.
+ *
+ * Splits are ranked by the information gain weighted by the number of observations, i.e. the decrease of
+ * the entropy of the whole tree, and ties are broken by the order of selection, so the tree is determined by the seed.
+ * Nodes are seeded by their positions, as grown depth first.
+ */
+{
+    vector<OpenNode> open_vec;                  // Open nodes, released once popped.
+    priority_queue<pair<double, int> > open_queue;  // Priority and negated index in <open_vec> of the open nodes.
+
+    Node* root = NULL;
+    int nleaves = 1;
+
+    VarSelectRes result;
+    map<int, vector<int> > hist_map;
+    if (!selectSplit(0, obs_buf_.size(), 0, seed_, *pfeature_vars_, sorted_obs_vecs, isbinned_ ? &hist_map : NULL, result, root, workspace_))
+        return root;
+    openNode(NULL, 0, 0, obs_buf_.size(), 0, seed_, *pfeature_vars_, sorted_obs_vecs, hist_map, result, open_vec, open_queue);
+
+    while (!open_queue.empty()) {
+        if (*pInterrupt_) return root;
+
+        OpenNode open_node = std::move(open_vec[-open_queue.top().second]);
+        open_queue.pop();
+
+        ObsRange obs_vec(obs_buf_.data() + open_node.begin_, obs_buf_.data() + open_node.end_, obs_count_.data());
+        int nchild = countChildren(open_node.result_);
+        Node* node;
+        if (nleaves + nchild - 1 > max_leaves_) {
+            // No room for the children in the budget of leaf nodes
+            countLimitStop(LIMIT_MAXLEAVES_IDX);
+            node = createLeafNode(obs_vec, obs_vec.weight(), false, workspace_);
+
+        } else if (max_nodes_ > 0 && nreserved_ + nchild > max_nodes_) {
+            // No room for the children in the budget of nodes
+            countLimitStop(LIMIT_MAXNODES_IDX);
+            node = createLeafNode(obs_vec, obs_vec.weight(), false, workspace_);
+
+        } else {
+            GrowFrame& frame = workspace_->getFrame(0);
+            node = splitNode(open_node.begin_, open_node.end_, open_node.depth_, open_node.seed_, open_node.var_vec_, open_node.sorted_obs_vecs_,
+                    isbinned_ ? &open_node.hist_map_ : NULL, open_node.result_, frame, workspace_);
+            nleaves += nchild - 1;
+
+            // Select the splits of all the children first, as the histograms of the siblings are needed to derive the last's.
+            const vector<int>& child_begin = frame.child_begin_;
+            vector<VarSelectRes> child_results(nchild);
+            vector<bool>         child_open(nchild, false);
+            for (int k = 0; k < nchild; k++) {
+                int child = frame.child_order_[k];
+                Node* leaf = NULL;
+                if (child_begin[child + 1] == child_begin[child]) {
+                    // Use parent node statistics
+                    leaf = createLeafNode(obs_vec, 0, false, workspace_);
+                } else {
+                    if (isbinned_ && k == nchild - 1) deriveHistograms(open_node.hist_map_, child_begin, frame.child_hist_maps_, child);
+                    child_open[child] = selectSplit(child_begin[child], child_begin[child + 1], open_node.depth_ + 1, childSeed(open_node.seed_, child),
+                            *frame.var_vec_, frame.child_sorted_vecs_[child], isbinned_ ? &frame.child_hist_maps_[child] : NULL, child_results[child], leaf, workspace_);
+                }
+                if (!child_open[child]) node->setChild(child, leaf);
+            }
+
+            for (int k = 0; k < nchild; k++) {
+                int child = frame.child_order_[k];
+                if (child_open[child])
+                    openNode(node, child, child_begin[child], child_begin[child + 1], open_node.depth_ + 1, childSeed(open_node.seed_, child), *frame.var_vec_,
+                            frame.child_sorted_vecs_[child], frame.child_hist_maps_[child], child_results[child], open_vec, open_queue);
+            }
+            releaseChildren(frame);
+        }
+
+        if (open_node.parent_) open_node.parent_->setChild(open_node.child_, node);
+        else root = node;
+
+        workspace_->endNode();
+    }
+
+    return root;
+}
+
+void Tree::openNode (Node* parent, int child, int begin, int end, int depth, unsigned seed, const vector<int>& var_vec, vector<vector<int> >& sorted_obs_vecs,
+        map<int, vector<int> >& hist_map, const VarSelectRes& result, vector<OpenNode>& open_vec, priority_queue<pair<double, int> >& open_queue)
+/*
+ * Queue a node with its split selected in <result> for best first growth.
+ * The node takes over <sorted_obs_vecs> and <hist_map>.
+ */
+{
+    int index = open_vec.size();
+    open_vec.push_back(OpenNode());
+    OpenNode& open_node = open_vec.back();
+
+    open_node.parent_  = parent;
+    open_node.child_   = child;
+    open_node.begin_   = begin;
+    open_node.end_     = end;
+    open_node.depth_   = depth;
+    open_node.seed_    = seed;
+    open_node.result_  = result;
+    open_node.var_vec_ = var_vec;
+    open_node.sorted_obs_vecs_.swap(sorted_obs_vecs);
+    open_node.hist_map_.swap(hist_map);
+
+    ObsRange obs_vec(obs_buf_.data() + begin, obs_buf_.data() + end, obs_count_.data());
+    open_queue.push(make_pair(result.info_gain_ * obs_vec.weight(), -index));
+}
+
+Node* Tree::growNode (int begin, int end, int depth, unsigned seed, const vector<int>& var_vec, vector<vector<int> >& sorted_obs_vecs, map<int, vector<int> >* hist_map, Workspace* ws)
+/*
+ * Grow a node at <depth> seeded <seed> on the observations [begin, end) in <obs_buf_>.
+ *
+ * If it is split, partition its observations, and fill the frame of <depth> in <ws> for growing its children.
+ * <hist_map> holds the label histograms of binned variables known for this node, and collects those counted here,
+ * NULL if not binned.
+ */
+{
+    VarSelectRes result;
+    Node* node;
+    if (selectSplit(begin, end, depth, seed, var_vec, sorted_obs_vecs, hist_map, result, node, ws))
+        node = splitNode(begin, end, depth, seed, var_vec, sorted_obs_vecs, hist_map, result, ws->getFrame(depth), ws);
+
+    ws->endNode();
+    return node;
+}
+
+bool Tree::selectSplit (int begin, int end, int depth, unsigned seed, const vector<int>& var_vec, vector<vector<int> >& sorted_obs_vecs, map<int, vector<int> >* hist_map, VarSelectRes& result, Node*& leaf, Workspace* ws)
+/*
+ * Select the split of a node at <depth> seeded <seed> on the observations [begin, end) in <obs_buf_>.
+ *
+ * Return true with the split in <result>, or otherwise false with a leaf node created in <leaf>,
+ * which is NULL if interrupted in parallel.
+ */
+{
+    leaf = NULL;
 
     if (!isParallel_ && check_interrupt()) {
         // If run sequentially, check user interruption directly.
         throw interrupt_exception(MODEL_INTERRUPT_MSG);
     } else if (*pInterrupt_ ) {
         // Otherwise, return immediately if run in parallel.
-        return NULL;
+        return false;
     }
 
-    int nobs = obs_vec.size();
+    ObsRange obs_vec(obs_buf_.data() + begin, obs_buf_.data() + end, obs_count_.data());
+    int nobs = obs_vec.weight();
     if (targ_data_->haveSameLabel(obs_vec)) {
         // All observations have the same class label
-        return createLeafNode(obs_vec, nobs, true);
+        leaf = createLeafNode(obs_vec, nobs, true, ws);
 
     } else if (var_vec.size() == 0) {
         // No variables left for split
-        return createLeafNode(obs_vec, nobs, false);
+        leaf = createLeafNode(obs_vec, nobs, false, ws);
+
+    } else if (max_depth_ > 0 && depth >= max_depth_) {
+        // Too deep to split
+        countLimitStop(LIMIT_MAXDEPTH_IDX);
+        leaf = createLeafNode(obs_vec, nobs, false, ws);
+
+    } else if (max_nodes_ > 0 && nreserved_ + 2 > max_nodes_) {
+        // No room for even two children
+        countLimitStop(LIMIT_MAXNODES_IDX);
+        leaf = createLeafNode(obs_vec, nobs, false, ws);
 
     } else {
-        VarSelectRes result;
+        const vector<vector<int> >* psorted_obs_vecs = ispresort_ ? &sorted_obs_vecs : NULL;
+        C4p5Selector method(train_set_, targ_data_, meta_data_, min_node_size_, nrand_splits_, igr_sampsize_, obs_vec, var_vec, mtry_, seed,
+                pInterrupt_, isParallel_, ws, scheduler_, thread_workspaces_, psorted_obs_vecs, hist_map);
         if (isweight_) {
-            C4p5Selector method(train_set_, targ_data_, meta_data_, min_node_size_, obs_vec, var_vec, mtry_, seed_, pInterrupt_, isParallel_);
             method.doIGRSelection(result);
         } else {
-            C4p5Selector method(train_set_, targ_data_, meta_data_, min_node_size_, obs_vec, var_vec, mtry_, seed_, pInterrupt_, isParallel_);
             method.doSelection(result);
         }
 
-        seed_ += 1;  // Change seed.
-
         if (!result.ok_) {
             // If no better attribute selected
-            return createLeafNode(obs_vec, nobs, false);
+            leaf = createLeafNode(obs_vec, nobs, false, ws);
 
-        } else {
-            Node* node;
+        } else if (min_gain_ > 0 && result.info_gain_ < min_gain_) {
+            // Not worth splitting
+            countLimitStop(LIMIT_MINGAIN_IDX);
+            leaf = createLeafNode(obs_vec, nobs, false, ws);
 
-            if (meta_data_->getVarType(result.var_idx_) == DISCRETE) {
-                node = createInternalNode(nobs, result);
-                vector<int> new_var_vec = removeOneVar(var_vec, result.var_idx_);
-                for (map<int, vector<int> >::iterator iter = result.split_map_.begin(); iter != result.split_map_.end(); ++iter) {
-                    if (iter->second.size() == 0) {
-                        // Use parent node statistics
-                        node->setChild(iter->first, createLeafNode(obs_vec, 0, false));
-                    } else {
-                        node->setChild(iter->first, genC4p5Tree(iter->second, new_var_vec));
-                    }
-                }
-            } else {
-                node = createInternalNode(nobs, result);
-                node->setSplitValue(result.split_value_);
-                for (map<int, vector<int> >::iterator iter = result.split_map_.begin(); iter != result.split_map_.end(); ++iter)
-                    node->setChild(iter->first, genC4p5Tree(iter->second, var_vec));
-            }
+        } else if (max_nodes_ > 0 && nreserved_ + countChildren(result) > max_nodes_) {
+            // No room for the children, as for a discrete variable of many values
+            countLimitStop(LIMIT_MAXNODES_IDX);
+            leaf = createLeafNode(obs_vec, nobs, false, ws);
 
-            return node;
+        } else {
+            return true;
         }
     }
+
+    return false;
+}
+
+Node* Tree::splitNode (int begin, int end, int depth, unsigned seed, const vector<int>& var_vec, vector<vector<int> >& sorted_obs_vecs, map<int, vector<int> >* hist_map, const VarSelectRes& result, GrowFrame& frame, Workspace* ws)
+/*
+ * Split a node by <result>: Partition its observations, create the internal node,
+ * and fill <frame> for growing its children.
+ */
+{
+    vector<int>& child_begin = frame.child_begin_;
+    vector<int>& child_nobs = ws->child_nobs_vec_;
+    partitionObs(begin, end, result, child_begin, child_nobs, ws);
+    int nchild = child_begin.size() - 1;
+    if (max_nodes_ > 0) nreserved_ += nchild;
+
+    int nobs = 0;
+    for (int i = 0; i < nchild; i++)
+        nobs += child_nobs[i];
+
+    Node* node = createInternalNode(nobs, nchild, result);
+    frame.node_     = node;
+    frame.depth_    = depth;
+    frame.seed_     = seed;
+    frame.hist_map_ = hist_map;
+    frame.next_     = 0;
+
+    if (meta_data_->getVarType(result.var_idx_) == DISCRETE) {
+        removeOneVar(var_vec, result.var_idx_, frame.new_var_vec_);
+        frame.var_vec_ = &frame.new_var_vec_;
+    } else {
+        frame.var_vec_ = &var_vec;
+        node->setSplitValue(result.split_value_);
+    }
+
+    frame.child_sorted_vecs_.resize(nchild);
+    if (ispresort_) splitSortedObsVecs(sorted_obs_vecs, child_begin, frame.child_sorted_vecs_);
+
+    // If binned, grow the largest child at last, so that its histograms can be derived from the siblings'.
+    vector<int>& child_order = frame.child_order_;
+    child_order.resize(nchild);
+    for (int i = 0; i < nchild; i++)
+        child_order[i] = i;
+    if (isbinned_)
+        stable_sort(child_order.begin(), child_order.end(), [&child_nobs](int a, int b) {
+            return child_nobs[a] < child_nobs[b];
+        });
+
+    frame.child_hist_maps_.resize(nchild);
+    for (int i = 0; i < nchild; i++)
+        frame.child_hist_maps_[i].clear();
+
+    return node;
 }
 
 template<class T>
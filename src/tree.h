@@ -3,6 +3,8 @@
 
 #include <iostream>
 #include <queue>
+#include <mutex>
+#include <atomic>
 
 #include "c4_5_var_selector.h"
 #include "dataset.h"
@@ -13,8 +15,9 @@ using namespace std;
 class Tree {
 private:
 
-    unsigned    seed_;                  // Random seed for this tree.
+    unsigned    seed_;                  // Random seed for this tree, and its root node.
     Node*       root_;                  // Root node of the tree.
+    NodeArena   arena_;                 // Memory of all the nodes, freed with the tree.
     Dataset*    train_set_;             // Training set the tree built from.
     TargetData* targ_data_;
     MetaData*   meta_data_;             // Meta data.
@@ -22,19 +25,57 @@ private:
     int         node_id_;               // For printing tree.
     double      tree_oob_error_rate_;   // Out-of-bag error rate.
     int         min_node_size_;         // Minimum node size.
+    int         max_depth_;             // Maximum depth of nodes, the root at depth 0, no limit if 0.
+    int         max_nodes_;             // Maximum number of nodes, no limit if 0.
+    int         max_leaves_;            // Maximum number of leaf nodes if grown best first, or 0 if grown depth first.
+    double      min_gain_;              // Minimum information gain of a split.
+    int         nrand_splits_;          // Number of random split points tried for a continuous variable, 0 to try all.
+    int         igr_sampsize_;          // Number of observations subsampled to estimate the weights of variables, 0 to use all.
+    int         nreserved_;             // Number of nodes grown or waiting to be grown, counted only if <max_nodes_> limits them.
     int         mtry_;                  // Number of variables selected for node splitting.
+    const vector<int>* pfeature_vars_;  // Variables the root node selects from, all the feature variables unless screened.
+    const vector<int>* psampsize_;      // Number of observations drawn into the bagging set, in total, or for each class label if more than one.
+    bool        isreplace_;             // Whether draw observations with replacement.
     bool        isweight_;              // Whether weighting.
     bool        isimportance_;          // Whether calculate variable importance.
+    bool        ispresort_;             // Whether nodes get sorted orders of continuous variables by partitioning the parent's.
+    bool        isbinned_;              // Whether continuous variables are split by scanning label histograms of bins.
+    Workspace*  workspace_;             // Scratch memory for node splitting, owned by the building thread.
+    TaskScheduler* scheduler_;          // Thread pool building the forest, NULL if built sequentially.
+    vector<Workspace>* thread_workspaces_;  // Scratch memory of each thread of <scheduler_>, for the subtrees and variables shared with it.
+    mutex       mut_;                   // Guards the arena and the counters while subtrees grow concurrently.
 
     vector<double> label_oob_error_rate_;  // Vector of size nlabels: The OOB error rate for each class label.
+    vector<int>    limit_stop_vec_;        // Vector of size LIMIT_NUM: Number of nodes made leaves by each limit on growth.
+    int            ws_growths_;            // Number of nodes grown in <workspace_> during which it grew.
 
     vector<vector<double> > tree_;     // Serialized tree.
 
-    vector<int>* pbagging_vec_;  // Bagging set
-    vector<int>* poob_vec_;      // Out-of-bag set: The size of it may be one third of the number of observations.
+    vector<int>* poob_vec_;      // Out-of-bag set: The size of it may be one third of the number of observations, or more if sampled less.
 
     vector<int> oob_predict_label_set_;  // The predicted labels for Out-of-bag set: The same size of *poob_vec_.
 
+    vector<int> obs_buf_;     // Index buffer of the distinct observations in the bagging set while growing: Each node owns a range of it, partitioned in place for its children.
+    vector<int> obs_count_;   // Vector of size nobs: Number of times each observation is drawn into the bagging set, while growing.
+    vector<int> child_mark_;  // Vector of size nobs: The child node each observation goes to, for partitioning the index buffer and presorted orders.
+
+    struct OpenNode
+    /*
+     * A node whose split is selected but not made yet, waiting in the queue of genBestFirstTree().
+     */
+    {
+        Node*                  parent_;  // NULL for the root.
+        int                    child_;   // Index of the node among the children of <parent_>.
+        int                    begin_;   // The node owns observations [begin_, end_) in <obs_buf_>.
+        int                    end_;
+        int                    depth_;
+        unsigned               seed_;
+        VarSelectRes           result_;
+        vector<int>            var_vec_;          // Variables left for the node.
+        vector<vector<int> >   sorted_obs_vecs_;  // Sorted orders of the node if presorted.
+        map<int, vector<int> > hist_map_;         // Label histograms of the node if binned.
+    };
+
     int            perm_var_idx_;      // Should variable importance be assessed (-1), or otherwise, the index of current permuted variable.
     vector<bool>   perm_is_var_used_;  // Vector of size nvars: Indicate whether the variable is used for node splitting in this tree.
     vector<double> perm_var_data_;     // Vector of size nobs: Permuted data of variable perm_var_idx_.
@@ -44,17 +85,40 @@ private:
     volatile bool* pInterrupt_;  // Interruption or exception flag.
     bool isParallel_;  // Run in parallel or not.
 
-    vector<int> removeOneVar (const vector<int>& var_vec, int index)
+    static unsigned childSeed (unsigned seed, int child)
+    /*
+     * Return the seed of child <child> of a node seeded <seed>, so that the seed of a node depends only on
+     * its position in the tree, not on the order in which the nodes are grown.
+     */
+    {
+        seed_seq seq {seed, (unsigned) child};
+        unsigned res;
+        seq.generate(&res, &res + 1);
+        return res;
+    }
+
+    void countLimitStop (int limit_idx) {
+        lock_guard<mutex> lk(mut_);
+        limit_stop_vec_[limit_idx]++;
+    }
+
+    int countChildren (const VarSelectRes& res)
     /*
-     * Remove a <index> from <var_vec>.
+     * Return the number of child nodes of a split.
+     */
+    {
+        return meta_data_->getVarType(res.var_idx_) == DISCRETE ? meta_data_->getNumValues(res.var_idx_) : 2;
+    }
+
+    void removeOneVar (const vector<int>& var_vec, int index, vector<int>& res)
+    /*
+     * Copy <var_vec> into <res> without <index>.
      */
     {
         int n = var_vec.size();
-        vector<int> res(n - 1);
+        res.resize(n - 1);
         for (int i = 0, j = 0; i < n; i++)
             if (var_vec[i] != index) res[j++] = var_vec[i];
-
-        return res;
     }
 
     template<class T>
@@ -141,6 +205,15 @@ private:
         node->save(tree_[nth_iter], meta_data_);
     }
 
+    void addOneIGRVI (Node* node, int nth_iter)
+    /*
+     * Add the information gain ratio of an internal node to the importance of its variable.
+     */
+    {
+        if (node->type() != LEAFNODE && node->getGainRatio() != NA_REAL)
+            tree_IGR_VIs_[node->getVarIdx()] += node->getGainRatio();
+    }
+
     void markOneVarUsed (Node* node, int nth_iter)
     /*
      * Check whether the node is internal node and mark the variable as used for node splitting.
@@ -150,10 +223,22 @@ private:
             perm_is_var_used_[node->getVarIdx()] = true;
     }
 
-    void deleteTheNode (Node* node, int nth_iter) {
-        if (node != NULL)
-            delete node;
-    }
+
+    void drawObs (default_random_engine& re, const int* obs_array, int n, int ndraw);
+    void genSortedObsVecs (vector<vector<int> >& sorted_obs_vecs);
+    Node* growSubtree (int begin, int end, int depth, unsigned seed, const vector<int>& var_vec, vector<vector<int> >& sorted_obs_vecs, map<int, vector<int> >* hist_map, Workspace* ws);
+    Node* growNode (int begin, int end, int depth, unsigned seed, const vector<int>& var_vec, vector<vector<int> >& sorted_obs_vecs, map<int, vector<int> >* hist_map, Workspace* ws);
+    bool isWorthSharing (const GrowFrame& frame);
+    void growChildrenParallel (GrowFrame& frame, Workspace* ws);
+    bool selectSplit (int begin, int end, int depth, unsigned seed, const vector<int>& var_vec, vector<vector<int> >& sorted_obs_vecs, map<int, vector<int> >* hist_map, VarSelectRes& result, Node*& leaf, Workspace* ws);
+    Node* splitNode (int begin, int end, int depth, unsigned seed, const vector<int>& var_vec, vector<vector<int> >& sorted_obs_vecs, map<int, vector<int> >* hist_map, const VarSelectRes& result, GrowFrame& frame, Workspace* ws);
+    Node* genBestFirstTree (vector<vector<int> >& sorted_obs_vecs);
+    void openNode (Node* parent, int child, int begin, int end, int depth, unsigned seed, const vector<int>& var_vec, vector<vector<int> >& sorted_obs_vecs,
+            map<int, vector<int> >& hist_map, const VarSelectRes& result, vector<OpenNode>& open_vec, priority_queue<pair<double, int> >& open_queue);
+    void partitionObs (int begin, int end, const VarSelectRes& res, vector<int>& child_begin, vector<int>& child_nobs, Workspace* ws);
+    void splitSortedObsVecs (vector<vector<int> >& sorted_obs_vecs, const vector<int>& child_begin, vector<vector<vector<int> > >& child_sorted_vecs);
+    void releaseChildren (GrowFrame& frame);
+    void deriveHistograms (const map<int, vector<int> >& hist_map, const vector<int>& child_begin, vector<map<int, vector<int> > >& child_hist_maps, int child);
 
     void printTree (Node* node, int level);
     void calcOOBMeasures (bool importance);
@@ -164,11 +249,7 @@ private:
 public:
 
     Tree (const vector<vector<double> >& node_infos, MetaData* meta_data, double tree_oob_error_rate);
-    Tree (Dataset*, TargetData*, MetaData*, int, unsigned int, vector<int>*, vector<int>*, int, bool, bool, volatile bool*, bool);
-
-    ~Tree () {
-        doSthOnNodes(root_, &Tree::deleteTheNode);
-    }
+    Tree (Dataset*, TargetData*, MetaData*, int, int, int, int, double, int, int, unsigned int, vector<int>*, const vector<int>*, bool, int, const vector<int>*, bool, bool, bool, Workspace*, TaskScheduler*, vector<Workspace>*, volatile bool*, bool);
 
     vector<double>& getTreePermVIs () {
         return tree_perm_VIs_;
@@ -182,10 +263,22 @@ public:
         tree_IGR_VIs_.swap(tree_IGR_VIs);
     }
 
+    Node* getRoot () {
+        return root_;
+    }
+
     double getTreeOOBErrorRate () {
         return tree_oob_error_rate_;
     }
 
+    vector<int>& getLimitStops () {
+        return limit_stop_vec_;
+    }
+
+    int getWorkspaceGrowths () {
+        return ws_growths_;
+    }
+
     vector<int>& getOOBPredictLabelSet () {
         return oob_predict_label_set_;
     }
@@ -194,45 +287,51 @@ public:
         oob_predict_label_set_.swap(oob_predict_label_set);
     }
 
-    Node* genC4p5Tree (const vector<int>& training_set_index, const vector<int>& attribute_list);
+    Node* genC4p5Tree (vector<vector<int> >& sorted_obs_vecs);
 
-    Node* createLeafNode (const vector<int>& obs_vec, int nobs, bool pure)
+    Node* createLeafNode (const ObsRange& obs_vec, int nobs, bool pure, Workspace* ws)
     /*
      * Create a leaf node.
      * Because all observations are the same label (pure = true),
      * or there is no better variable to split (pure = false).
      */
     {
-        ++nnodes_;
-        Node* node = new Node(LEAFNODE, nobs);
+        vector<int>& numbers = ws->label_count_vec_;
+        int label = -1;
         if (pure) {  // All observations have the same label.
-            int label = targ_data_->getLabel(obs_vec[0]) - 1;
-            node->setLabel(label);
-
-            vector<int> numbers(meta_data_->nlabels(), 0);
-            numbers[label] = obs_vec.size();
-            node->setLabelFreqCount(numbers);
+            label = targ_data_->getLabel(obs_vec[0]) - 1;
+            numbers.assign(meta_data_->nlabels(), 0);
+            numbers[label] = obs_vec.weight();
         } else {  // There is no better variable to split.
-            node->setLabelFreqCount(targ_data_->getLabelFreqCount(obs_vec), true);
+            targ_data_->getLabelFreqCount(obs_vec, numbers);
+        }
+
+        lock_guard<mutex> lk(mut_);
+        ++nnodes_;
+        Node* node = arena_.create<Node>(arena_, LEAFNODE, nobs);
+        if (pure) {
+            node->setLabel(label);
+            node->setLabelFreqCount(arena_, numbers);
+        } else {
+            node->setLabelFreqCount(arena_, numbers, true);
         }
         return node;
     }
 
-    Node* createInternalNode (int nobs, VarSelectRes& res)
+    Node* createInternalNode (int nobs, int nchild, const VarSelectRes& res)
     /*
      * Create a internal node.
      * It represents the variable selected to split the data,
      * with related impurity measures.
      */
     {
+        lock_guard<mutex> lk(mut_);
         ++nnodes_;
-        Node* node = new Node(INTERNALNODE, nobs, res.split_map_.size());
+        Node* node = arena_.create<Node>(arena_, INTERNALNODE, nobs, nchild);
         node->setVarIdx(res.var_idx_);
         node->setInfoGain(res.info_gain_);
         node->setSplitInfo(res.split_info_);
         node->setGainRatio(res.gain_ratio_);
-        if (res.gain_ratio_ != NA_REAL)
-            tree_IGR_VIs_[res.var_idx_] += res.gain_ratio_;
         return node;
     }
 
@@ -30,9 +30,67 @@ typedef struct attribute_selection_result {
     double info_gain_;
     double split_info_;
     double gain_ratio_;
-    map<int, vector<int> > split_map_;
 } VarSelectRes;
 
+class ObsRange
+/*
+ * Observations [begin, end) of a tree node, as a range of the index buffer of the tree,
+ * or of any vector of observation indexes.
+ *
+ * Each observation appears once, and stands for as many copies as it is drawn into the bootstrap sample,
+ * which is looked up in <count>, indexed by observation.  Statistics count the copies.
+ */
+{
+private:
+    const int* begin_;
+    const int* end_;
+    const int* count_;
+
+public:
+    ObsRange (const int* begin, const int* end, const int* count)
+        : begin_(begin), end_(end), count_(count) {
+    }
+
+    ObsRange (const vector<int>& obs_vec, const int* count)
+        : begin_(obs_vec.data()), end_(obs_vec.data() + obs_vec.size()), count_(count) {
+    }
+
+    int count (int obs) const {
+        return count_[obs];
+    }
+
+    const int* counts () const {
+        return count_;
+    }
+
+    int weight () const
+    /*
+     * The number of copies of all the observations.
+     */
+    {
+        int n = 0;
+        for (const int* p = begin_; p != end_; ++p)
+            n += count_[*p];
+        return n;
+    }
+
+    const int* begin () const {
+        return begin_;
+    }
+
+    const int* end () const {
+        return end_;
+    }
+
+    int size () const {
+        return end_ - begin_;
+    }
+
+    int operator[] (int i) const {
+        return begin_[i];
+    }
+};
+
 class interrupt_exception: public std::exception {
 public:
     interrupt_exception(std::string message) :
@@ -77,10 +135,14 @@ const int PRED_TYPE_PROB   = 1 << PRED_TYPE_PROB_IDX;    // 4,  0x000100
 const int PRED_TYPE_APROB  = 1 << PRED_TYPE_APROB_IDX;   // 8,  0x001000
 const int PRED_TYPE_WAPROB = 1 << PRED_TYPE_WAPROB_IDX;  // 16, 0x010000
 
+const int PRED_BLOCK_SIZE  = 256;  // Number of observations pushed through one tree after another at a time.
+const size_t PRED_BLOCK_MIN_BYTES = 256 * 1024;  // Minimum size of a compiled forest to predict tree by tree, about a L2 cache.
+const int PAR_NODE_MIN_OBS = 8192;  // Minimum number of observations of a node to evaluate its variables in parallel.
+
 
 
 // wsrf$
-const int WSRF_MODEL_SIZE          = 19;
+const int WSRF_MODEL_SIZE          = 22;
 
 const int META_IDX                 = 0;
 const int TARGET_DATA_IDX          = 1;
@@ -101,6 +163,16 @@ const int C_S2_IDX                 = 15;
 const int WEIGHTS_IDX              = 16;
 const int MTRY_IDX                 = 17;
 const int NODESIZE_IDX             = 18;
+const int TREE_LIMIT_STOPS_IDX     = 19;
+const int SCREENING_IDX            = 20;
+const int TREE_WS_GROWTHS_IDX      = 21;
+
+// Limits on tree growth, indexes of the number of nodes each stopped from splitting.
+const int LIMIT_NUM                = 4;
+const int LIMIT_MAXDEPTH_IDX       = 0;
+const int LIMIT_MAXNODES_IDX       = 1;
+const int LIMIT_MINGAIN_IDX        = 2;
+const int LIMIT_MAXLEAVES_IDX      = 3;
 
 // targetData$
 const string TRAIN_TARGET_LABELS  = "trainTargLabels";
@@ -125,6 +197,7 @@ const string UNMATCHED_NUM_OF_VAR_MSG = "The number of variables is less than ex
 const string UNEXPECTED_VAR_TYPE_MSG  = ": Unexpected variable type.";
 const string VAR_NOT_FOUND_MSG        = ": Variable not found.";
 const string UNEXPECTED_VALUE_MSG     = ": Unexpected values found.";
+const string NO_SCREENED_VAR_MSG      = "No variable is kept by the screening.";
 
 
 #endif
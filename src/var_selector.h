@@ -10,17 +10,17 @@ protected:
     Dataset*    train_set_;
     TargetData* targ_data_;
     MetaData*   meta_data_;
-    int         nobs_;  // size of obs_vec_
+    int         nobs_;  // Number of observations in obs_vec_, counting bootstrap copies.
 
-    const vector<int>& obs_vec_;
+    ObsRange           obs_vec_;
     const vector<int>& var_vec_;
 
 public:
 
-    VarSelector (Dataset* train_set, TargetData* targdata, MetaData* meta_data, const vector<int>& obs_vec, const vector<int>& var_vec)
+    VarSelector (Dataset* train_set, TargetData* targdata, MetaData* meta_data, const ObsRange& obs_vec, const vector<int>& var_vec)
         : obs_vec_(obs_vec),
           var_vec_(var_vec) {
-        nobs_ = obs_vec.size();
+        nobs_ = obs_vec.weight();
         train_set_ = train_set;
         targ_data_ = targdata;
         meta_data_ = meta_data;
@@ -0,0 +1,164 @@
+#ifndef WORKSPACE_H_
+#define WORKSPACE_H_
+
+#include <deque>
+
+#include "utility.h"
+
+using namespace std;
+
+class Node;
+
+struct GrowFrame
+/*
+ * An internal node whose children are being grown, on the explicit stack of Tree::growSubtree().
+ */
+{
+    Node*                   node_;
+    int                     depth_;        // Depth of the node.
+    unsigned                seed_;         // Seed of the node, from which the seeds of its children are derived.
+    const vector<int>*      var_vec_;      // Variables left for the children.
+    vector<int>             new_var_vec_;  // Variables left if split by a discrete variable, pointed to by <var_vec_>.
+    map<int, vector<int> >* hist_map_;     // Label histograms of the node.
+    vector<int>             child_begin_;  // Child i owns observations [child_begin_[i], child_begin_[i+1]) in the index buffer of the tree.
+    vector<int>             child_order_;  // Order to grow the children.
+    int                     next_;         // Position in <child_order_> of the next child to grow.
+
+    vector<vector<vector<int> > >   child_sorted_vecs_;  // Sorted orders of each child if presorted.
+    vector<map<int, vector<int> > > child_hist_maps_;    // Label histograms of each child if binned.
+};
+
+class Workspace
+/*
+ * Scratch memory for node splitting, owned by one tree building thread
+ * and reused for all the nodes of all the trees it builds.
+ *
+ * Per-variable results are stored in flat arrays indexed by variable, and the frames
+ * of the nodes whose children are being grown are kept on a stack indexed by depth.
+ * Buffers only grow, so after the first few nodes (warm-up) no more
+ * heap allocation is needed, which is tracked by ngrowths().
+ *
+ * The sorted orders of presorted nodes and the label histograms of binned nodes are not counted,
+ * as they hold the data of the nodes, and are released once their subtrees are grown.
+ */
+{
+private:
+    int    nvars_;
+    int    max_nchild_;  // Maximum number of children of a node, reserved for each frame.
+    size_t capacity_;    // Total capacity of all buffers at the end of last node.
+    int    nnodes_;      // Number of nodes handled.
+    int    ngrowths_;    // Number of nodes during which any buffer grew.
+
+    deque<GrowFrame> frames_;  // Frame of depth i at position i, references to which stay valid while the stack grows.
+
+    size_t totalCapacity () const {
+        size_t capacity = info_gain_vec_.capacity() + split_info_vec_.capacity() + split_value_vec_.capacity()
+            + cand_var_vec_.capacity() + cand_gain_ratio_vec_.capacity()
+            + sorted_obs_vec_.capacity() + left_dstr_.capacity() + right_dstr_.capacity() + label_count_vec_.capacity()
+            + scatter_vec_.capacity() + child_nobs_vec_.capacity()
+            + level_label_vec_.capacity() + level_count_vec_.capacity() + sub_obs_vec_.capacity() + igr_var_vec_.capacity()
+            + rank_label_vec_.capacity() + rank_first_vec_.capacity() + rank_last_vec_.capacity()
+            + sample_vec_.capacity() + pool_vec_.capacity() + weights_.capacity() + wst_.capacity()
+            + frames_.size();
+        for (const GrowFrame& frame : frames_)
+            capacity += frame.new_var_vec_.capacity() + frame.child_begin_.capacity() + frame.child_order_.capacity()
+                + frame.child_sorted_vecs_.capacity() + frame.child_hist_maps_.capacity();
+
+        return capacity;
+    }
+
+public:
+
+    vector<double> info_gain_vec_;    // Vector of size nvars: Information gain for each variable.
+    vector<double> split_info_vec_;   // Vector of size nvars: Split info for each variable.
+    vector<double> split_value_vec_;  // Vector of size nvars: Optimal split value for each continuous variable.
+    vector<int>    cand_var_vec_;     // Variables with positive information gain in the node, in ascending order.
+
+    vector<double> cand_gain_ratio_vec_;  // Information gain ratios of candidate variables for IGR weighting.
+
+    vector<int> sorted_obs_vec_;   // Observations of the node sorted by a continuous variable, or a copy of them when partitioning.
+    vector<int> left_dstr_;        // Vector of size nlabels: Label frequency count on the left of a split point.
+    vector<int> right_dstr_;       // Vector of size nlabels: Label frequency count on the right of a split point.
+    vector<int> label_count_vec_;  // Vector of size nlabels: Label frequency count of a node or a child node.
+    vector<int> scatter_vec_;      // Next position to fill for each child node when partitioning a node.
+    vector<int> child_nobs_vec_;   // Vector of size nchild: Number of observations of each child node, counting copies.
+    vector<int> level_label_vec_;  // Matrix of size nlevels*nlabels: Label frequency count for each level of a discrete variable.
+    vector<int> level_count_vec_;  // Vector of size nlevels: Frequency count of each level of a discrete variable.
+    vector<int> rank_label_vec_;   // Matrix of size nranks*nlabels: Label frequency count for each rank of a continuous variable.
+    vector<int> rank_first_vec_;   // Vector of size nranks: The first observation of each rank in the sorted order, -1 if none.
+    vector<int> rank_last_vec_;    // Vector of size nranks: The last observation of each rank in the sorted order, -1 if none.
+
+    vector<int>    sample_vec_;  // Sampled variables or their indexes.
+    vector<int>    pool_vec_;    // Variables not yet sampled.
+    vector<double> weights_;     // Weights for weighted sampling.
+    vector<int>    wst_;         // Weight sum tree for weighted sampling.
+
+    vector<int> sub_obs_vec_;  // Observations of the node shuffled, the first ones subsampled to estimate the weights of variables for IGR.
+    vector<int> igr_var_vec_;  // Variables sampled by the estimated weights for IGR.
+
+    Workspace (int nvars, int nlabels, int max_nchild) {
+        nvars_           = nvars;
+        max_nchild_      = max_nchild;
+        info_gain_vec_   = vector<double>(nvars);
+        split_info_vec_  = vector<double>(nvars);
+        split_value_vec_ = vector<double>(nvars);
+        cand_var_vec_.reserve(nvars);
+        cand_gain_ratio_vec_.reserve(nvars);
+        sample_vec_.reserve(nvars);
+        pool_vec_.reserve(nvars);
+        weights_.reserve(nvars + 1);
+        wst_.reserve(nvars + 1);
+        igr_var_vec_.reserve(nvars);
+        left_dstr_.reserve(nlabels);
+        right_dstr_.reserve(nlabels);
+        label_count_vec_.reserve(nlabels);
+        scatter_vec_.reserve(max_nchild);
+        child_nobs_vec_.reserve(max_nchild);
+        level_label_vec_.reserve(max_nchild * nlabels);
+        level_count_vec_.reserve(max_nchild);
+
+        nnodes_   = 0;
+        ngrowths_ = 0;
+        capacity_ = totalCapacity();
+    }
+
+    GrowFrame& getFrame (int depth)
+    /*
+     * Return the frame for a node at <depth>, with room for the children of any split.
+     */
+    {
+        while ((int) frames_.size() <= depth) {
+            frames_.push_back(GrowFrame());
+            GrowFrame& frame = frames_.back();
+            frame.new_var_vec_.reserve(nvars_);
+            frame.child_begin_.reserve(max_nchild_ + 1);
+            frame.child_order_.reserve(max_nchild_);
+            frame.child_sorted_vecs_.reserve(max_nchild_);
+            frame.child_hist_maps_.reserve(max_nchild_);
+        }
+
+        return frames_[depth];
+    }
+
+    void endNode ()
+    /*
+     * Mark the end of a node, and count it if any buffer grew during it.
+     */
+    {
+        size_t capacity = totalCapacity();
+        if (capacity != capacity_) ngrowths_++;
+        capacity_ = capacity;
+        nnodes_++;
+    }
+
+    int nnodes () const {
+        return nnodes_;
+    }
+
+    int ngrowths () const {
+        return ngrowths_;
+    }
+
+};
+
+#endif
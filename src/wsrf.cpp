@@ -17,7 +17,20 @@ SEXP wsrf (
     SEXP parallelSEXP,   // Whether parallel or how many cores performing parallelism.
     SEXP seedsSEXP,      // Random seeds for each trees.
     SEXP importanceSEXP, // Whether calculate variable importance measures.
-    SEXP ispartSEXP      // Indicating whether it is part of the whole forests.
+    SEXP ispartSEXP,     // Indicating whether it is part of the whole forests.
+    SEXP presortSEXP,    // Whether presort continuous variables once for all trees.
+    SEXP rankencodeSEXP, // Whether encode continuous variables by their ranks once for all trees.
+    SEXP binningSEXP,    // Maximum number of bins for continuous variables, 0 for no binning.
+    SEXP sampsizeSEXP,   // Number of observations drawn for each tree, in total or for each class label.
+    SEXP replaceSEXP,    // Whether draw observations with replacement.
+    SEXP maxdepthSEXP,   // Maximum depth of nodes, 0 for no limit.
+    SEXP maxnodesSEXP,   // Maximum number of nodes in each tree, 0 for no limit.
+    SEXP mingainSEXP,    // Minimum information gain of a split.
+    SEXP maxleavesSEXP,  // Maximum number of leaf nodes in each tree grown best first, 0 for growing depth first.
+    SEXP nrandsplitsSEXP,// Number of random split points tried for a continuous variable, 0 to try all.
+    SEXP igrsampsizeSEXP,// Number of observations subsampled to estimate the weights of variables, 0 to use all.
+    SEXP screenvarsSEXP, // Number of variables kept by the screening on the training set, 0 for no limit.
+    SEXP screenratioSEXP // Minimum information gain ratio of variables kept by the screening, negative for no limit.
     )
 /*
  * Main entry function for building random forests model.
@@ -43,8 +56,12 @@ SEXP wsrf (
         volatile bool interrupt = false;
 
         RForest rf (&train_set, &targ_data, &meta_data,
-                    Rcpp::as<int>(ntreeSEXP), Rcpp::as<int>(nvarsSEXP), Rcpp::as<int>(minnodeSEXP), Rcpp::as<bool>(weightsSEXP),
-                    Rcpp::as<bool>(importanceSEXP), seedsSEXP, &interrupt);
+                    Rcpp::as<int>(ntreeSEXP), Rcpp::as<int>(nvarsSEXP), Rcpp::as<int>(minnodeSEXP),
+                    Rcpp::as<int>(maxdepthSEXP), Rcpp::as<int>(maxnodesSEXP), Rcpp::as<int>(maxleavesSEXP),
+                    Rcpp::as<double>(mingainSEXP), Rcpp::as<int>(nrandsplitsSEXP), Rcpp::as<int>(igrsampsizeSEXP),
+                    Rcpp::as<int>(screenvarsSEXP), Rcpp::as<double>(screenratioSEXP), Rcpp::as<bool>(weightsSEXP),
+                    Rcpp::as<bool>(importanceSEXP), Rcpp::as<bool>(presortSEXP), Rcpp::as<bool>(rankencodeSEXP), Rcpp::as<int>(binningSEXP),
+                    Rcpp::as<vector<int> >(sampsizeSEXP), Rcpp::as<bool>(replaceSEXP), seedsSEXP, &interrupt);
 
 
 
@@ -61,29 +78,18 @@ SEXP wsrf (
             future<void> res = async(launch::async, &RForest::buildForestAsync, &rf, nthreads);
             try {
 
-                while (true) {
-
-                    // check interruption per 100 milliseconds.
-                    this_thread::sleep_for(chrono::milliseconds {100});
+                // Wake up when the forest is built, or per 100 milliseconds to check interruption.
+#if (defined(__GNUC__) && ((__GNUC__ == 4 && __GNUC_MINOR__ >= 7) || (__GNUC__ >= 5))) || defined(__clang__)
+                while (res.wait_for(chrono::milliseconds {100}) != future_status::ready) {
+#else  // #if __GNUC__ >= 4 && __GNUC_MINOR__ >= 7
+                while (!res.wait_for(chrono::milliseconds {100})) {
+#endif // #if __GNUC__ >= 4 && __GNUC_MINOR__ >= 7
                     if (check_interrupt()) {
                         interrupt = true;
                         throw interrupt_exception(MODEL_INTERRUPT_MSG);
                     }
-
-//                    interrupt = true;
-//                    throw interrupt_exception(MODEL_INTERRUPT_MSG);
-
-                    // check RF thread completion
-
-#if (defined(__GNUC__) && ((__GNUC__ == 4 && __GNUC_MINOR__ >= 7) || (__GNUC__ >= 5))) || defined(__clang__)
-                    if (res.valid() && res.wait_for(chrono::milliseconds {0}) == future_status::ready) {
-#else  // #if __GNUC__ >= 4 && __GNUC_MINOR__ >= 7
-                    if (res.valid() && res.wait_for(chrono::milliseconds {0})) {
-#endif // #if __GNUC__ >= 4 && __GNUC_MINOR__ >= 7
-                        res.get();  // May throw exception.
-                        break;
-                    } // if ()
-                } // while (true)
+                }
+                res.get();  // May throw exception.
 
             } catch (...) {  // Interrupted or exception from sub-thread.
 
@@ -147,17 +153,87 @@ SEXP afterMergeOrSubset (SEXP wsrfSEXP) {
     END_RCPP
 }
 
-SEXP predict (SEXP wsrfSEXP, SEXP xSEXP, SEXP typeSEXP) {
+class CompiledModel
+/*
+ * A model ready for prediction, kept by R in an external pointer.
+ */
+{
+public:
+    MetaData meta_data_;
+    RForest  rf_;
+
+    CompiledModel (Rcpp::List& wsrf_R)
+        : meta_data_ (Rcpp::as<Rcpp::List>((SEXPREC*)wsrf_R[META_IDX])),
+          rf_        (wsrf_R, &meta_data_, NULL, true) {
+    }
+};
+
+static void finalizeCompiledModel (SEXP handleSEXP) {
+    CompiledModel* model = (CompiledModel*) R_ExternalPtrAddr(handleSEXP);
+    if (model != NULL) {
+        delete model;
+        R_ClearExternalPtr(handleSEXP);
+    }
+}
+
+static CompiledModel* getCompiledModel (SEXP handleSEXP, Rcpp::List& wsrf_R)
+/*
+ * Get the compiled model in external pointer <handleSEXP>.
+ *
+ * The pointer is NULL after the handle is serialized and loaded in R, then compile the model again.
+ */
+{
+    CompiledModel* model = (CompiledModel*) R_ExternalPtrAddr(handleSEXP);
+    if (model == NULL) {
+        model = new CompiledModel(wsrf_R);
+        R_SetExternalPtrAddr(handleSEXP, model);
+        R_RegisterCFinalizerEx(handleSEXP, finalizeCompiledModel, TRUE);
+    }
+    return model;
+}
 
+SEXP compile (SEXP wsrfSEXP)
+/*
+ * Compile the model into an external pointer for repeated prediction.
+ */
+{
     BEGIN_RCPP
 
-        Rcpp::List wsrf_R    (wsrfSEXP);
-        MetaData   meta_data (Rcpp::as<Rcpp::List>((SEXPREC*)wsrf_R[META_IDX]));
-        Dataset    test_set  (xSEXP, &meta_data, false);
-        RForest    rf        (wsrf_R, &meta_data, NULL);
+        Rcpp::List wsrf_R (wsrfSEXP);
+        CompiledModel* model = new CompiledModel(wsrf_R);
+
+        SEXP handleSEXP = PROTECT(R_MakeExternalPtr(model, R_NilValue, R_NilValue));
+        R_RegisterCFinalizerEx(handleSEXP, finalizeCompiledModel, TRUE);
+        UNPROTECT(1);
+        return handleSEXP;
+
+    END_RCPP
+}
+
+SEXP predict (SEXP wsrfSEXP, SEXP xSEXP, SEXP typeSEXP, SEXP parallelSEXP, SEXP handleSEXP) {
+
+    BEGIN_RCPP
+
+        Rcpp::List wsrf_R   (wsrfSEXP);
+        int        type     = Rcpp::as<int>(typeSEXP);
+        int        parallel = Rcpp::as<int>(parallelSEXP);
+
+        if (Rf_isNull(handleSEXP)) {
+
+            MetaData   meta_data (Rcpp::as<Rcpp::List>((SEXPREC*)wsrf_R[META_IDX]));
+            Dataset    test_set  (xSEXP, &meta_data, false);
+            RForest    rf        (wsrf_R, &meta_data, NULL, true);
+
+            return rf.predict(&test_set, type, parallel);
 
-        int type = Rcpp::as<int>(typeSEXP);
-        return rf.predict(&test_set, type);
+        } else {
+
+            CompiledModel* model = getCompiledModel(handleSEXP, wsrf_R);
+            Dataset test_set (xSEXP, &model->meta_data_, false);
+
+            return model->rf_.predict(&test_set, type, parallel);
+
+        }
 
     END_RCPP
 }
@@ -25,9 +25,23 @@ RcppExport SEXP wsrf (
     SEXP parallelSEXP,
     SEXP seedsSEXP,
     SEXP importanceSEXP,
-    SEXP isPartSEXP);
+    SEXP isPartSEXP,
+    SEXP presortSEXP,
+    SEXP rankencodeSEXP,
+    SEXP binningSEXP,
+    SEXP sampsizeSEXP,
+    SEXP replaceSEXP,
+    SEXP maxdepthSEXP,
+    SEXP maxnodesSEXP,
+    SEXP mingainSEXP,
+    SEXP maxleavesSEXP,
+    SEXP nrandsplitsSEXP,
+    SEXP igrsampsizeSEXP,
+    SEXP screenvarsSEXP,
+    SEXP screenratioSEXP);
 
-RcppExport SEXP predict (SEXP wrfSEXP, SEXP xSEXP, SEXP typeSEXP);
+RcppExport SEXP compile (SEXP wsrfSEXP);
+RcppExport SEXP predict (SEXP wrfSEXP, SEXP xSEXP, SEXP typeSEXP, SEXP parallelSEXP, SEXP handleSEXP);
 RcppExport SEXP afterReduceForCluster (SEXP wrfSEXP, SEXP xSEXP, SEXP ySEXP);
 RcppExport SEXP afterMergeOrSubset (SEXP wsrfSEXP);
 RcppExport SEXP print (SEXP wsrfSEXP, SEXP treesSEXP);
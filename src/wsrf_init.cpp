@@ -6,9 +6,10 @@
 #define CALLDEF(name, n) {#name, (DL_FUNC) &name, n}
 
 static const R_CallMethodDef callEntries[] = {
-    CALLDEF(wsrf, 10),
+    CALLDEF(wsrf, 23),
     CALLDEF(print, 2),
-    CALLDEF(predict, 3),
+    CALLDEF(compile, 1),
+    CALLDEF(predict, 5),
     CALLDEF(afterReduceForCluster, 3),
     CALLDEF(afterMergeOrSubset, 1),
     {NULL, NULL, 0}